@@ -0,0 +1,175 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include "calibration.hpp"
+
+
+namespace SecurityCam {
+
+//
+// ScoreHistogram
+//
+
+constexpr qreal ScoreHistogram::c_max;
+constexpr qreal Calibration::c_profileBand;
+
+//! Width of the bin.
+static const qreal c_binWidth = ScoreHistogram::c_max / ( ScoreHistogram::c_bins - 1 );
+
+ScoreHistogram::ScoreHistogram()
+	:	m_count( 0 )
+{
+	m_bins.fill( 0 );
+}
+
+void
+ScoreHistogram::add( qreal v )
+{
+	const int bin = ( v >= c_max ? c_bins - 1 :
+		qBound( 0, (int) ( v / c_binWidth ), c_bins - 2 ) );
+
+	++m_bins[ bin ];
+	++m_count;
+}
+
+quint64
+ScoreHistogram::count() const
+{
+	return m_count;
+}
+
+qreal
+ScoreHistogram::percentile( qreal p ) const
+{
+	if( m_count == 0 )
+		return 0.0;
+
+	const qreal rank = qBound( 0.0, p, 1.0 ) * m_count;
+	quint64 below = 0;
+
+	for( int i = 0; i < c_bins; ++i )
+	{
+		if( below + m_bins[ i ] >= rank && m_bins[ i ] > 0 )
+		{
+			if( i == c_bins - 1 )
+				return c_max;
+
+			// Linear interpolation inside the bin.
+			return c_binWidth * ( i + ( rank - below ) / m_bins[ i ] );
+		}
+
+		below += m_bins[ i ];
+	}
+
+	return c_max;
+}
+
+void
+ScoreHistogram::clear()
+{
+	m_bins.fill( 0 );
+	m_count = 0;
+}
+
+
+//
+// Calibration
+//
+
+Calibration::Calibration()
+	:	m_percentile( 0.99 )
+	,	m_margin( 0.005 )
+	,	m_nightLuma( 0.25 )
+	,	m_profile( Day )
+	,	m_otherProfileFrames( 0 )
+{
+}
+
+void
+Calibration::setRules( qreal percentile, qreal margin, qreal nightLuma )
+{
+	m_percentile = percentile;
+	m_margin = margin;
+	m_nightLuma = nightLuma;
+}
+
+qreal
+Calibration::percentile() const
+{
+	return m_percentile;
+}
+
+qreal
+Calibration::margin() const
+{
+	return m_margin;
+}
+
+qreal
+Calibration::nightLuma() const
+{
+	return m_nightLuma;
+}
+
+Calibration::Profile
+Calibration::profile( qreal luma ) const
+{
+	return ( luma < m_nightLuma ? Night : Day );
+}
+
+Calibration::Profile
+Calibration::updateProfile( qreal luma )
+{
+	const bool other = ( m_profile == Day ? luma < m_nightLuma - c_profileBand :
+		luma > m_nightLuma + c_profileBand );
+
+	if( !other )
+		m_otherProfileFrames = 0;
+	else if( ++m_otherProfileFrames >= c_profileConfirmations )
+	{
+		m_profile = ( m_profile == Day ? Night : Day );
+		m_otherProfileFrames = 0;
+	}
+
+	return m_profile;
+}
+
+Calibration::Profile
+Calibration::currentProfile() const
+{
+	return m_profile;
+}
+
+void
+Calibration::add( qreal score, qreal luma )
+{
+	m_histograms[ profile( luma ) ].add( score );
+}
+
+quint64
+Calibration::count( Profile p ) const
+{
+	return m_histograms[ p ].count();
+}
+
+qreal
+Calibration::threshold( Profile p ) const
+{
+	if( m_histograms[ p ].count() < (quint64) c_minSamples )
+		return -1.0;
+
+	return m_histograms[ p ].percentile( m_percentile ) + m_margin;
+}
+
+void
+Calibration::clear()
+{
+	for( auto & h : m_histograms )
+		h.clear();
+}
+
+} /* namespace SecurityCam */
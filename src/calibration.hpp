@@ -0,0 +1,126 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef SECURITYCAM_CALIBRATION_HPP_INCLUDED
+#define SECURITYCAM_CALIBRATION_HPP_INCLUDED
+
+// Qt include.
+#include <QtGlobal>
+
+// C++ include.
+#include <array>
+
+
+namespace SecurityCam {
+
+//
+// ScoreHistogram
+//
+
+//! Streaming histogram of scores with fixed count of bins, values above
+//! maximum go to the last bin.
+class ScoreHistogram final {
+public:
+	//! Count of bins.
+	static const int c_bins = 512;
+	//! Upper bound of the last but one bin.
+	static constexpr qreal c_max = 0.25;
+
+	ScoreHistogram();
+
+	//! Add value.
+	void add( qreal v );
+	//! \return Count of values.
+	quint64 count() const;
+	//! \return Value below which the given fraction of values is, from 0 to 1.
+	qreal percentile( qreal p ) const;
+	//! Forget values.
+	void clear();
+
+private:
+	//! Bins.
+	std::array< quint32, c_bins > m_bins;
+	//! Count.
+	quint64 m_count;
+}; // class ScoreHistogram
+
+
+//
+// Calibration
+//
+
+//! Calibration of threshold from scores of a quiet scene, separately by
+//! day and by night. Current profile changes only when mean luma is out of
+//! the band around night luma on c_profileConfirmations key frames in a row,
+//! so dusk, dawn and flickering light don't switch it on every key frame.
+class Calibration final {
+public:
+	//! Profile.
+	enum Profile {
+		//! Day.
+		Day = 0,
+		//! Night.
+		Night = 1,
+		//! Count of profiles.
+		ProfilesCount = 2
+	}; // enum Profile
+
+	//! Minimum count of samples to calculate threshold.
+	static const int c_minSamples = 30;
+	//! Half of the band of mean luma around night luma where profile is kept.
+	static constexpr qreal c_profileBand = 0.02;
+	//! Count of key frames in a row to change profile.
+	static const int c_profileConfirmations = 5;
+
+	Calibration();
+
+	//! Set rules. Threshold is the percentile of scores plus margin, frames
+	//! with mean luma below nightLuma belong to the night profile.
+	void setRules( qreal percentile, qreal margin, qreal nightLuma );
+	//! \return Percentile.
+	qreal percentile() const;
+	//! \return Margin.
+	qreal margin() const;
+	//! \return Mean luma of night.
+	qreal nightLuma() const;
+
+	//! \return Profile of the frame with the given mean luma.
+	Profile profile( qreal luma ) const;
+
+	//! Update current profile with mean luma of the key frame.
+	//! \return Current profile.
+	Profile updateProfile( qreal luma );
+	//! \return Current profile.
+	Profile currentProfile() const;
+
+	//! Add score of the frame with the given mean luma.
+	void add( qreal score, qreal luma );
+	//! \return Count of samples of the profile.
+	quint64 count( Profile p ) const;
+	//! \return Threshold of the profile, or -1 if there are not enough samples.
+	qreal threshold( Profile p ) const;
+
+	//! Forget samples.
+	void clear();
+
+private:
+	//! Histograms of profiles.
+	std::array< ScoreHistogram, ProfilesCount > m_histograms;
+	//! Percentile.
+	qreal m_percentile;
+	//! Margin.
+	qreal m_margin;
+	//! Mean luma of night.
+	qreal m_nightLuma;
+	//! Current profile.
+	Profile m_profile;
+	//! Count of key frames in a row with the other profile.
+	int m_otherProfileFrames;
+}; // class Calibration
+
+} /* namespace SecurityCam */
+
+#endif // SECURITYCAM_CALIBRATION_HPP_INCLUDED
@@ -0,0 +1,468 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include "convert.hpp"
+#include "kernels.hpp"
+#include "scale.hpp"
+
+// Qt include.
+#include <QMap>
+#include <QVector>
+
+
+namespace SecurityCam {
+
+//
+// Planes
+//
+
+//! Planes of the mapped frame.
+struct Planes {
+	//! Count of planes.
+	int m_count;
+	//! Data.
+	const uchar * m_bits[ 3 ];
+	//! Bytes per line.
+	int m_bytesPerLine[ 3 ];
+	//! Coefficients of YUV.
+	YuvMatrix m_matrix;
+}; // struct Planes
+
+
+//
+// yuvToRgb
+//
+
+//! \return Channel rounded and clamped to 0..255.
+static inline int
+clamp255( float v )
+{
+	return qBound( 0, qRound( v ), 255 );
+}
+
+//! \return RGB of YUV with the given coefficients.
+static inline QRgb
+yuvToRgb( int y, int u, int v, const YuvMatrix & m )
+{
+	const float l = ( y - m.m_yOffset ) * m.m_yScale;
+	const float d = u - 128.0f;
+	const float e = v - 128.0f;
+
+	return qRgb( clamp255( l + m.m_rv * e ),
+		clamp255( l + m.m_gu * d + m.m_gv * e ),
+		clamp255( l + m.m_bu * d ) );
+}
+
+
+//
+// Layouts
+//
+
+// Layouts convert lines of the frame with line() and give channels of one
+// pixel with sample(), YUV if c_yuv is set and RGB otherwise.
+
+//! Packed 4:2:2, two pixels in four bytes with the given offsets of the first
+//! luma, U and V. The second luma is two bytes after the first.
+template< int Y, int U, int V >
+struct Packed422 {
+	static const int c_planes = 1;
+	static const bool c_yuv = true;
+
+	static void line( const Planes & p, int y, int width, QRgb * out )
+	{
+		const uchar * s = p.m_bits[ 0 ] + y * p.m_bytesPerLine[ 0 ];
+
+		int x = 0;
+
+		for( ; x + 2 <= width; x += 2, s += 4 )
+		{
+			out[ x ] = yuvToRgb( s[ Y ], s[ U ], s[ V ], p.m_matrix );
+			out[ x + 1 ] = yuvToRgb( s[ Y + 2 ], s[ U ], s[ V ], p.m_matrix );
+		}
+
+		if( x < width )
+			out[ x ] = yuvToRgb( s[ Y ], s[ U ], s[ V ], p.m_matrix );
+	}
+
+	static void sample( const Planes & p, int x, int y, int * c )
+	{
+		const uchar * s = p.m_bits[ 0 ] + y * p.m_bytesPerLine[ 0 ] + ( x / 2 ) * 4;
+
+		c[ 0 ] += s[ Y + ( x % 2 ) * 2 ];
+		c[ 1 ] += s[ U ];
+		c[ 2 ] += s[ V ];
+	}
+}; // struct Packed422
+
+//! YUYV with vectorized conversion of lines.
+struct Yuyv
+	:	public Packed422< 0, 1, 3 >
+{
+	static void line( const Planes & p, int y, int width, QRgb * out )
+	{
+		Kernels::instance().yuyvRow()( p.m_bits[ 0 ] + y * p.m_bytesPerLine[ 0 ],
+			reinterpret_cast< uchar* > ( out ), width, p.m_matrix );
+	}
+}; // struct Yuyv
+
+//! UYVY with vectorized conversion of lines.
+struct Uyvy
+	:	public Packed422< 1, 0, 2 >
+{
+	static void line( const Planes & p, int y, int width, QRgb * out )
+	{
+		Kernels::instance().uyvyRow()( p.m_bits[ 0 ] + y * p.m_bytesPerLine[ 0 ],
+			reinterpret_cast< uchar* > ( out ), width, p.m_matrix );
+	}
+}; // struct Uyvy
+
+//! Semi-planar 4:2:0, luma plane and plane of interleaved chroma with the
+//! given offsets of U and V.
+template< int U, int V >
+struct SemiPlanar420 {
+	static const int c_planes = 2;
+	static const bool c_yuv = true;
+
+	static void line( const Planes & p, int y, int width, QRgb * out )
+	{
+		const uchar * l = p.m_bits[ 0 ] + y * p.m_bytesPerLine[ 0 ];
+		const uchar * c = p.m_bits[ 1 ] + ( y / 2 ) * p.m_bytesPerLine[ 1 ];
+
+		int x = 0;
+
+		for( ; x + 2 <= width; x += 2 )
+		{
+			out[ x ] = yuvToRgb( l[ x ], c[ x + U ], c[ x + V ], p.m_matrix );
+			out[ x + 1 ] = yuvToRgb( l[ x + 1 ], c[ x + U ], c[ x + V ], p.m_matrix );
+		}
+
+		if( x < width )
+			out[ x ] = yuvToRgb( l[ x ], c[ x + U ], c[ x + V ], p.m_matrix );
+	}
+
+	static void sample( const Planes & p, int x, int y, int * c )
+	{
+		const uchar * uv = p.m_bits[ 1 ] + ( y / 2 ) * p.m_bytesPerLine[ 1 ] +
+			( x / 2 ) * 2;
+
+		c[ 0 ] += p.m_bits[ 0 ][ y * p.m_bytesPerLine[ 0 ] + x ];
+		c[ 1 ] += uv[ U ];
+		c[ 2 ] += uv[ V ];
+	}
+}; // struct SemiPlanar420
+
+//! NV12 with vectorized conversion of lines.
+struct Nv12
+	:	public SemiPlanar420< 0, 1 >
+{
+	static void line( const Planes & p, int y, int width, QRgb * out )
+	{
+		Kernels::instance().nv12Row()( p.m_bits[ 0 ] + y * p.m_bytesPerLine[ 0 ],
+			p.m_bits[ 1 ] + ( y / 2 ) * p.m_bytesPerLine[ 1 ],
+			reinterpret_cast< uchar* > ( out ), width, p.m_matrix );
+	}
+}; // struct Nv12
+
+//! Planar 4:2:0 with the given planes of U and V, lines are converted with
+//! vectorized kernel.
+template< int U, int V >
+struct Planar420 {
+	static const int c_planes = 3;
+	static const bool c_yuv = true;
+
+	static void line( const Planes & p, int y, int width, QRgb * out )
+	{
+		Kernels::instance().yuv420Row()( p.m_bits[ 0 ] + y * p.m_bytesPerLine[ 0 ],
+			p.m_bits[ U ] + ( y / 2 ) * p.m_bytesPerLine[ U ],
+			p.m_bits[ V ] + ( y / 2 ) * p.m_bytesPerLine[ V ],
+			reinterpret_cast< uchar* > ( out ), width, p.m_matrix );
+	}
+
+	static void sample( const Planes & p, int x, int y, int * c )
+	{
+		c[ 0 ] += p.m_bits[ 0 ][ y * p.m_bytesPerLine[ 0 ] + x ];
+		c[ 1 ] += p.m_bits[ U ][ ( y / 2 ) * p.m_bytesPerLine[ U ] + x / 2 ];
+		c[ 2 ] += p.m_bits[ V ][ ( y / 2 ) * p.m_bytesPerLine[ V ] + x / 2 ];
+	}
+}; // struct Planar420
+
+//! 32-bit RGB with the given offsets of bytes of R, G and B, alpha is ignored.
+template< int R, int G, int B >
+struct Rgb32 {
+	static const int c_planes = 1;
+	static const bool c_yuv = false;
+
+	static void line( const Planes & p, int y, int width, QRgb * out )
+	{
+		const uchar * s = p.m_bits[ 0 ] + y * p.m_bytesPerLine[ 0 ];
+
+		for( int x = 0; x < width; ++x, s += 4 )
+			out[ x ] = qRgb( s[ R ], s[ G ], s[ B ] );
+	}
+
+	static void sample( const Planes & p, int x, int y, int * c )
+	{
+		const uchar * s = p.m_bits[ 0 ] + y * p.m_bytesPerLine[ 0 ] + x * 4;
+
+		c[ 0 ] += s[ R ];
+		c[ 1 ] += s[ G ];
+		c[ 2 ] += s[ B ];
+	}
+}; // struct Rgb32
+
+//! 8-bit luma.
+struct Gray8 {
+	static const int c_planes = 1;
+	static const bool c_yuv = false;
+
+	static void line( const Planes & p, int y, int width, QRgb * out )
+	{
+		const uchar * s = p.m_bits[ 0 ] + y * p.m_bytesPerLine[ 0 ];
+
+		for( int x = 0; x < width; ++x )
+			out[ x ] = qRgb( s[ x ], s[ x ], s[ x ] );
+	}
+
+	static void sample( const Planes & p, int x, int y, int * c )
+	{
+		const int l = p.m_bits[ 0 ][ y * p.m_bytesPerLine[ 0 ] + x ];
+
+		c[ 0 ] += l;
+		c[ 1 ] += l;
+		c[ 2 ] += l;
+	}
+}; // struct Gray8
+
+
+//
+// Converter
+//
+
+//! Converter of the frame of the given size to the image, image may be
+//! smaller than the frame. \return Is frame converted.
+typedef bool ( * Converter )( const Planes & p, int width, int height,
+	QImage & image );
+
+//! Convert the frame with the given layout. Downscaling is done with box
+//! filter on channels of the frame in the same pass, so each pixel of the
+//! image is converted once.
+template< typename Layout >
+static bool
+convertLines( const Planes & p, int width, int height, QImage & image )
+{
+	if( p.m_count < Layout::c_planes || image.width() > width ||
+		image.height() > height )
+			return false;
+
+	const int dw = image.width();
+	const int dh = image.height();
+
+	if( dw == width && dh == height )
+	{
+		for( int y = 0; y < dh; ++y )
+			Layout::line( p, y, dw, reinterpret_cast< QRgb* > ( image.scanLine( y ) ) );
+
+		return true;
+	}
+
+	QVector< int > xs( dw + 1 );
+
+	for( int x = 0; x <= dw; ++x )
+		xs[ x ] = (int) ( (qint64) x * width / dw );
+
+	QVector< int > acc( dw * 3 );
+
+	for( int y = 0; y < dh; ++y )
+	{
+		const int y0 = (int) ( (qint64) y * height / dh );
+		const int y1 = qMax( y0 + 1, (int) ( (qint64) ( y + 1 ) * height / dh ) );
+
+		acc.fill( 0 );
+
+		for( int sy = y0; sy < y1; ++sy )
+		{
+			for( int x = 0; x < dw; ++x )
+			{
+				const int x1 = qMax( xs[ x ] + 1, xs[ x + 1 ] );
+
+				for( int sx = xs[ x ]; sx < x1; ++sx )
+					Layout::sample( p, sx, sy, acc.data() + x * 3 );
+			}
+		}
+
+		QRgb * out = reinterpret_cast< QRgb* > ( image.scanLine( y ) );
+
+		for( int x = 0; x < dw; ++x )
+		{
+			const int n = qMax( xs[ x ] + 1, xs[ x + 1 ] ) - xs[ x ];
+			const int count = n * ( y1 - y0 );
+			const int * c = acc.constData() + x * 3;
+			const int a = ( c[ 0 ] + count / 2 ) / count;
+			const int b = ( c[ 1 ] + count / 2 ) / count;
+			const int d = ( c[ 2 ] + count / 2 ) / count;
+
+			out[ x ] = ( Layout::c_yuv ? yuvToRgb( a, b, d, p.m_matrix ) :
+				qRgb( a, b, d ) );
+		}
+	}
+
+	return true;
+}
+
+//! \return Converter of the pixel format, nullptr if there is no such one.
+static Converter
+converter( QVideoFrameFormat::PixelFormat format )
+{
+	static const QMap< QVideoFrameFormat::PixelFormat, Converter > c_converters = {
+		{ QVideoFrameFormat::Format_NV12, &convertLines< Nv12 > },
+		{ QVideoFrameFormat::Format_NV21, &convertLines< SemiPlanar420< 1, 0 > > },
+		{ QVideoFrameFormat::Format_YUYV, &convertLines< Yuyv > },
+		{ QVideoFrameFormat::Format_UYVY, &convertLines< Uyvy > },
+		{ QVideoFrameFormat::Format_YUV420P, &convertLines< Planar420< 1, 2 > > },
+		{ QVideoFrameFormat::Format_YV12, &convertLines< Planar420< 2, 1 > > },
+		{ QVideoFrameFormat::Format_BGRA8888, &convertLines< Rgb32< 2, 1, 0 > > },
+		{ QVideoFrameFormat::Format_BGRX8888, &convertLines< Rgb32< 2, 1, 0 > > },
+		{ QVideoFrameFormat::Format_RGBA8888, &convertLines< Rgb32< 0, 1, 2 > > },
+		{ QVideoFrameFormat::Format_RGBX8888, &convertLines< Rgb32< 0, 1, 2 > > },
+		{ QVideoFrameFormat::Format_ARGB8888, &convertLines< Rgb32< 1, 2, 3 > > },
+		{ QVideoFrameFormat::Format_XRGB8888, &convertLines< Rgb32< 1, 2, 3 > > },
+		{ QVideoFrameFormat::Format_ABGR8888, &convertLines< Rgb32< 3, 2, 1 > > },
+		{ QVideoFrameFormat::Format_XBGR8888, &convertLines< Rgb32< 3, 2, 1 > > },
+		{ QVideoFrameFormat::Format_Y8, &convertLines< Gray8 > }
+	};
+
+	return c_converters.value( format, nullptr );
+}
+
+
+//
+// isConvertible
+//
+
+bool
+isConvertible( QVideoFrameFormat::PixelFormat format )
+{
+	return ( converter( format ) != nullptr );
+}
+
+
+//
+// frameMatrix
+//
+
+//! \return Coefficients of YUV of the frame, BT.601 of limited range if
+//! the frame doesn't tell.
+static YuvMatrix
+frameMatrix( const QVideoFrameFormat & format )
+{
+#if QT_VERSION >= QT_VERSION_CHECK( 6, 4, 0 )
+	return yuvMatrix( format.colorSpace() == QVideoFrameFormat::ColorSpace_BT709,
+		format.colorRange() == QVideoFrameFormat::ColorRange_Full );
+#else
+	switch( format.yCbCrColorSpace() )
+	{
+		case QVideoFrameFormat::YCbCr_BT709 :
+		case QVideoFrameFormat::YCbCr_xvYCC709 :
+			return yuvMatrix( true, false );
+
+		case QVideoFrameFormat::YCbCr_JPEG :
+			return yuvMatrix( false, true );
+
+		default :
+			return yuvMatrix( false, false );
+	}
+#endif
+}
+
+
+//
+// convertFrame
+//
+
+QImage
+convertFrame( const QVideoFrame & frame )
+{
+	return convertFrame( frame, frame.size() );
+}
+
+QImage
+convertFrame( const QVideoFrame & frame, const QSize & size )
+{
+	const Converter convert = converter( frame.pixelFormat() );
+
+	// Mirrored and bottom-up frames are left to Qt.
+	if( !convert || !frame.isMapped() || frame.surfaceFormat().isMirrored() ||
+		frame.surfaceFormat().scanLineDirection() != QVideoFrameFormat::TopToBottom )
+			return QImage();
+
+	QSize target = frame.size();
+
+	if( size.isValid() && ( size.width() < target.width() ||
+		size.height() < target.height() ) )
+			target.scale( size, Qt::KeepAspectRatio );
+
+	if( target.isEmpty() )
+		return QImage();
+
+	Planes p;
+	p.m_count = qMin( frame.planeCount(), 3 );
+	p.m_matrix = frameMatrix( frame.surfaceFormat() );
+
+	for( int i = 0; i < 3; ++i )
+	{
+		p.m_bits[ i ] = ( i < p.m_count ? frame.bits( i ) : nullptr );
+		p.m_bytesPerLine[ i ] = ( i < p.m_count ? frame.bytesPerLine( i ) : 0 );
+	}
+
+	QImage image( target, QImage::Format_RGB32 );
+
+	if( image.isNull() || !convert( p, frame.width(), frame.height(), image ) )
+		return QImage();
+
+	return image;
+}
+
+
+//
+// frameToImage
+//
+
+QImage
+frameToImage( QVideoFrame & frame )
+{
+	return frameToImage( frame, frame.size() );
+}
+
+QImage
+frameToImage( QVideoFrame & frame, const QSize & size )
+{
+	if( isConvertible( frame.pixelFormat() ) )
+	{
+		const bool mapped = frame.isMapped();
+
+		if( mapped || frame.map( QVideoFrame::ReadOnly ) )
+		{
+			const QImage image = convertFrame( frame, size );
+
+			if( !mapped )
+				frame.unmap();
+
+			if( !image.isNull() )
+				return image;
+		}
+	}
+
+	const QImage image = frame.toImage();
+
+	if( image.isNull() || !size.isValid() ||
+		( size.width() >= image.width() && size.height() >= image.height() ) )
+			return image;
+
+	return scaleToFit( image, size );
+}
+
+} /* namespace SecurityCam */
@@ -0,0 +1,60 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef SECURITYCAM_CONVERT_HPP_INCLUDED
+#define SECURITYCAM_CONVERT_HPP_INCLUDED
+
+// Qt include.
+#include <QImage>
+#include <QVideoFrame>
+#include <QVideoFrameFormat>
+
+
+namespace SecurityCam {
+
+//
+// isConvertible
+//
+
+//! \return Is pixel format converted by own converter, without toImage().
+bool
+isConvertible( QVideoFrameFormat::PixelFormat format );
+
+
+//
+// convertFrame
+//
+
+//! \return Mapped frame converted to 32-bit RGB image, null image if pixel
+//! format is not convertible.
+QImage
+convertFrame( const QVideoFrame & frame );
+
+//! \return Mapped frame converted to 32-bit RGB image downscaled to fit into
+//! the given size with kept aspect ratio, null image if pixel format is not
+//! convertible. Frame is scaled and converted in one pass.
+QImage
+convertFrame( const QVideoFrame & frame, const QSize & size );
+
+
+//
+// frameToImage
+//
+
+//! \return Frame converted to 32-bit RGB image with own converter, or with
+//! QVideoFrame::toImage() if pixel format is not convertible. Frame is
+//! mapped for conversion if it's not mapped.
+QImage
+frameToImage( QVideoFrame & frame );
+
+//! \return Frame converted to 32-bit RGB image downscaled to fit into the
+//! given size with kept aspect ratio, see frameToImage().
+QImage
+frameToImage( QVideoFrame & frame, const QSize & size );
+
+} /* namespace SecurityCam */
+
+#endif // SECURITYCAM_CONVERT_HPP_INCLUDED
@@ -0,0 +1,1089 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include "detector.hpp"
+#include "kernels.hpp"
+
+// Qt include.
+#include <QColor>
+#include <QtAlgorithms>
+
+// C++ include.
+#include <cmath>
+#include <vector>
+
+
+namespace SecurityCam {
+
+//
+// imagesDifference
+//
+
+qreal
+imagesDifference( const QImage & key, const QImage & image )
+{
+	return imagesDifference( key, image, nullptr );
+}
+
+qreal
+imagesDifference( const QImage & key, const QImage & image, float * pixels )
+{
+	return imagesDifference( key, image, pixels, 1.0, 0.0 );
+}
+
+//! \return Is image of 32-bit RGB pixels without premultiplied alpha.
+static bool
+isRgb32( const QImage & image )
+{
+	return ( image.format() == QImage::Format_RGB32 ||
+		image.format() == QImage::Format_ARGB32 );
+}
+
+qreal
+imagesDifference( const QImage & key, const QImage & image, float * pixels,
+	qreal gain, qreal offset )
+{
+	const int width = key.width();
+	const int height = key.height();
+
+	double errorL2 = 0.0;
+
+	if( isRgb32( key ) && isRgb32( image ) && key.size() == image.size() )
+	{
+		const DifferenceRow differenceRow = Kernels::instance().differenceRow();
+
+		for( int y = 0; y < height; ++y )
+			errorL2 += differenceRow( key.constScanLine( y ), image.constScanLine( y ),
+				( pixels ? pixels + y * width : nullptr ), width,
+				(float) gain, (float) offset );
+
+		return errorL2 / (double)( width * height );
+	}
+
+	// Calculate the L2 relative error between images.
+	for( int x = 0; x < width; ++x )
+	{
+		for( int y = 0; y < height; ++y )
+		{
+			const auto p1 = key.pixelColor( x, y );
+			const auto p2 = image.pixelColor( x, y );
+
+			const auto r = p1.redF() - ( p2.redF() * gain + offset );
+			const auto r2 = r * r;
+
+			const auto g = p1.greenF() - ( p2.greenF() * gain + offset );
+			const auto g2 = g * g;
+
+			const auto b = p1.blueF() - ( p2.blueF() * gain + offset );
+			const auto b2 = b * b;
+
+			const double e = std::sqrt( r2 + g2 + b2 );
+
+			errorL2 += e;
+
+			if( pixels )
+				pixels[ y * width + x ] = (float) e;
+		}
+	}
+
+	// Convert to a reasonable scale, since L2 error is summed across
+	// all pixels of the image.
+	return errorL2 / (double)( width * height );
+}
+
+
+//
+// lumaStatistics
+//
+
+//! Count of samples per line and per column of luma statistics.
+static const int c_lumaSamples = 64;
+
+void
+lumaStatistics( const QImage & image, qreal & mean, qreal & deviation )
+{
+	qreal laplacian = 0.0;
+
+	lumaStatistics( image, mean, deviation, laplacian );
+}
+
+void
+lumaStatistics( const QImage & image, qreal & mean, qreal & deviation,
+	qreal & laplacian )
+{
+	mean = 0.0;
+	deviation = 0.0;
+	laplacian = 0.0;
+
+	if( image.isNull() )
+		return;
+
+	const int width = image.width();
+	const int height = image.height();
+	const int stepX = qMax( 1, width / c_lumaSamples );
+	const int stepY = qMax( 1, height / c_lumaSamples );
+
+	double sum = 0.0;
+	double sum2 = 0.0;
+	qint64 count = 0;
+	double lapSum = 0.0;
+	double lapSum2 = 0.0;
+	qint64 lapCount = 0;
+
+	for( int y = stepY / 2; y < height; y += stepY )
+	{
+		for( int x = stepX / 2; x < width; x += stepX )
+		{
+			const int g = qGray( image.pixel( x, y ) );
+			const double l = g / 255.0;
+
+			sum += l;
+			sum2 += l * l;
+			++count;
+
+			if( x > 0 && x < width - 1 && y > 0 && y < height - 1 )
+			{
+				const int lap = 4 * g - qGray( image.pixel( x - 1, y ) ) -
+					qGray( image.pixel( x + 1, y ) ) - qGray( image.pixel( x, y - 1 ) ) -
+					qGray( image.pixel( x, y + 1 ) );
+
+				lapSum += lap;
+				lapSum2 += (double) lap * lap;
+				++lapCount;
+			}
+		}
+	}
+
+	mean = sum / count;
+	deviation = std::sqrt( qMax( 0.0, sum2 / count - mean * mean ) );
+
+	if( lapCount > 0 )
+	{
+		const double lapMean = lapSum / lapCount;
+
+		laplacian = lapSum2 / lapCount - lapMean * lapMean;
+	}
+}
+
+
+//
+// sharpness
+//
+
+//! Count of samples per line and per column.
+static const int c_sharpnessSamples = 256;
+
+qreal
+sharpness( const uchar * luma, int width, int height, int bytesPerLine,
+	int pixelStride )
+{
+	if( width < 3 || height < 3 )
+		return 0.0;
+
+	const int stepX = qMax( 1, width / c_sharpnessSamples );
+	const int stepY = qMax( 1, height / c_sharpnessSamples );
+
+	double sum = 0.0;
+	double sum2 = 0.0;
+	qint64 count = 0;
+
+	for( int y = 1; y < height - 1; y += stepY )
+	{
+		const uchar * up = luma + ( y - 1 ) * bytesPerLine;
+		const uchar * line = up + bytesPerLine;
+		const uchar * down = line + bytesPerLine;
+
+		for( int x = 1; x < width - 1; x += stepX )
+		{
+			const int i = x * pixelStride;
+			const int l = 4 * line[ i ] - line[ i - pixelStride ] -
+				line[ i + pixelStride ] - up[ i ] - down[ i ];
+
+			sum += l;
+			sum2 += (double) l * l;
+			++count;
+		}
+	}
+
+	const double mean = sum / count;
+
+	return sum2 / count - mean * mean;
+}
+
+
+//
+// fingerprint
+//
+
+//! Maximum count of samples per side of the cell.
+static const int c_fingerprintSamples = 8;
+
+QByteArray
+fingerprint( const QImage & image )
+{
+	if( image.width() < c_fingerprintSize || image.height() < c_fingerprintSize )
+		return QByteArray();
+
+	const QImage img = ( image.depth() == 32 ? image :
+		image.convertToFormat( QImage::Format_RGB32 ) );
+
+	QByteArray res( c_fingerprintSize * c_fingerprintSize, 0 );
+
+	for( int r = 0; r < c_fingerprintSize; ++r )
+	{
+		const int top = r * img.height() / c_fingerprintSize;
+		const int bottom = ( r + 1 ) * img.height() / c_fingerprintSize;
+		const int stepY = qMax( 1, ( bottom - top ) / c_fingerprintSamples );
+
+		for( int c = 0; c < c_fingerprintSize; ++c )
+		{
+			const int left = c * img.width() / c_fingerprintSize;
+			const int right = ( c + 1 ) * img.width() / c_fingerprintSize;
+			const int stepX = qMax( 1, ( right - left ) / c_fingerprintSamples );
+
+			int sum = 0;
+			int count = 0;
+
+			for( int y = top; y < bottom; y += stepY )
+			{
+				const QRgb * line = reinterpret_cast< const QRgb* > ( img.constScanLine( y ) );
+
+				for( int x = left; x < right; x += stepX )
+				{
+					sum += qGray( line[ x ] );
+					++count;
+				}
+			}
+
+			res[ r * c_fingerprintSize + c ] = (char) ( count > 0 ? sum / count : 0 );
+		}
+	}
+
+	return res;
+}
+
+qreal
+fingerprintDifference( const QByteArray & f1, const QByteArray & f2 )
+{
+	if( f1.isEmpty() || f1.size() != f2.size() )
+		return 1.0;
+
+	int sum = 0;
+
+	for( int i = 0; i < f1.size(); ++i )
+		sum += qAbs( (int) (uchar) f1.at( i ) - (int) (uchar) f2.at( i ) );
+
+	return (qreal) sum / ( 255.0 * f1.size() );
+}
+
+
+//
+// findBlobs
+//
+
+//! \return Root of the label, path is halved on the way.
+static inline int
+findRoot( std::vector< int > & parent, int l )
+{
+	while( parent[ l ] != l )
+	{
+		parent[ l ] = parent[ parent[ l ] ];
+		l = parent[ l ];
+	}
+
+	return l;
+}
+
+QVector< Blob >
+findBlobs( const uchar * mask, int width, int height )
+{
+	QVector< Blob > res;
+
+	if( width <= 0 || height <= 0 )
+		return res;
+
+	std::vector< int > labels( width * height, -1 );
+	std::vector< int > parent;
+
+	// First pass: provisional labels from left and upper neighbours,
+	// equivalences are merged with union-find.
+	for( int y = 0; y < height; ++y )
+	{
+		for( int x = 0; x < width; ++x )
+		{
+			const int i = y * width + x;
+
+			if( !mask[ i ] )
+				continue;
+
+			const int left = ( x > 0 ? labels[ i - 1 ] : -1 );
+			const int up = ( y > 0 ? labels[ i - width ] : -1 );
+
+			if( left < 0 && up < 0 )
+			{
+				labels[ i ] = (int) parent.size();
+				parent.push_back( labels[ i ] );
+			}
+			else if( left < 0 || up < 0 )
+				labels[ i ] = qMax( left, up );
+			else
+			{
+				const int r1 = findRoot( parent, left );
+				const int r2 = findRoot( parent, up );
+
+				labels[ i ] = qMin( r1, r2 );
+				parent[ qMax( r1, r2 ) ] = qMin( r1, r2 );
+			}
+		}
+	}
+
+	// Second pass: statistics of roots.
+	std::vector< int > blobOf( parent.size(), -1 );
+
+	for( int y = 0; y < height; ++y )
+	{
+		for( int x = 0; x < width; ++x )
+		{
+			const int l = labels[ y * width + x ];
+
+			if( l < 0 )
+				continue;
+
+			const int root = findRoot( parent, l );
+
+			if( blobOf[ root ] < 0 )
+			{
+				blobOf[ root ] = res.size();
+				res.append( { 0, QRect( x, y, 1, 1 ) } );
+			}
+
+			Blob & b = res[ blobOf[ root ] ];
+
+			++b.m_area;
+			b.m_rect |= QRect( x, y, 1, 1 );
+		}
+	}
+
+	return res;
+}
+
+
+//
+// MotionMap
+//
+
+//! Decay of the heat per key frame, in 1/256.
+static const int c_heatDecay = 216;
+
+MotionMap::MotionMap()
+	:	m_columns( 0 )
+	,	m_rows( 0 )
+{
+}
+
+bool
+MotionMap::isEmpty() const
+{
+	return m_diff.isEmpty();
+}
+
+void
+MotionMap::resize( const QSize & frameSize )
+{
+	m_frameSize = frameSize;
+
+	if( frameSize.isEmpty() )
+	{
+		m_columns = 0;
+		m_rows = 0;
+	}
+	else
+	{
+		m_columns = qMin( c_maxColumns, frameSize.width() );
+		m_rows = qBound( 1, qRound( (double) m_columns * frameSize.height() /
+			(double) frameSize.width() ), frameSize.height() );
+	}
+
+	m_diff.fill( 0.0f, m_columns * m_rows );
+	m_mask.fill( 0, m_columns * m_rows );
+	m_heat.fill( 0, m_columns * m_rows );
+	m_boxes.clear();
+}
+
+const QSize &
+MotionMap::frameSize() const
+{
+	return m_frameSize;
+}
+
+int
+MotionMap::columns() const
+{
+	return m_columns;
+}
+
+int
+MotionMap::rows() const
+{
+	return m_rows;
+}
+
+float *
+MotionMap::differences()
+{
+	return m_diff.data();
+}
+
+const float *
+MotionMap::differences() const
+{
+	return m_diff.constData();
+}
+
+void
+MotionMap::update( qreal threshold )
+{
+	const int count = m_columns * m_rows;
+
+	for( int i = 0; i < count; ++i )
+	{
+		m_mask[ i ] = ( m_diff.at( i ) > threshold ? 1 : 0 );
+		m_heat[ i ] = ( m_mask.at( i ) ? 255 : (uchar) ( m_heat.at( i ) * c_heatDecay / 256 ) );
+	}
+
+	m_boxes.clear();
+
+	// Bounding boxes of 4-connected cells with motion.
+	const auto blobs = findBlobs( m_mask.constData(), m_columns, m_rows );
+
+	for( const auto & b : blobs )
+		m_boxes.append( b.m_rect );
+}
+
+bool
+MotionMap::isMotion( int column, int row ) const
+{
+	return m_mask.at( row * m_columns + column ) != 0;
+}
+
+int
+MotionMap::heat( int column, int row ) const
+{
+	return m_heat.at( row * m_columns + column );
+}
+
+qreal
+MotionMap::coverage() const
+{
+	if( isEmpty() )
+		return 0.0;
+
+	int count = 0;
+
+	for( const auto m : m_mask )
+		count += m;
+
+	return (qreal) count / (qreal) m_mask.size();
+}
+
+const QVector< QRect > &
+MotionMap::boxes() const
+{
+	return m_boxes;
+}
+
+QImage
+MotionMap::overlay() const
+{
+	if( isEmpty() )
+		return QImage();
+
+	QImage res( m_columns, m_rows, QImage::Format_ARGB32_Premultiplied );
+
+	for( int y = 0; y < m_rows; ++y )
+	{
+		QRgb * line = reinterpret_cast< QRgb* > ( res.scanLine( y ) );
+
+		for( int x = 0; x < m_columns; ++x )
+		{
+			const int i = y * m_columns + x;
+			const int a = ( m_mask.at( i ) ? 128 : m_heat.at( i ) / 3 );
+
+			line[ x ] = qRgba( a, a / 4, 0, a );
+		}
+	}
+
+	return res;
+}
+
+
+//
+// Hysteresis
+//
+
+Hysteresis::Hysteresis()
+	:	m_confirmations( 1 )
+	,	m_window( 1 )
+	,	m_minDuration( 0 )
+	,	m_history( 0 )
+	,	m_samples( 0 )
+	,	m_on( false )
+	,	m_started( 0 )
+{
+}
+
+void
+Hysteresis::setRules( int confirmations, int window, qint64 minDuration )
+{
+	m_window = qBound( 1, window, c_maxWindow );
+	m_confirmations = qBound( 1, confirmations, m_window );
+	m_minDuration = qMax( Q_INT64_C( 0 ), minDuration );
+}
+
+int
+Hysteresis::confirmations() const
+{
+	return m_confirmations;
+}
+
+int
+Hysteresis::window() const
+{
+	return m_window;
+}
+
+qint64
+Hysteresis::minDuration() const
+{
+	return m_minDuration;
+}
+
+void
+Hysteresis::reset()
+{
+	m_history = 0;
+	m_samples = 0;
+	m_on = false;
+	m_started = 0;
+}
+
+bool
+Hysteresis::update( bool active, qint64 time )
+{
+	m_history = ( m_history << 1 ) | ( active ? 1 : 0 );
+	m_samples = qMin( m_samples + 1, m_window );
+
+	const quint64 mask = ( m_window == c_maxWindow ? ~Q_UINT64_C( 0 ) :
+		( Q_UINT64_C( 1 ) << m_window ) - 1 );
+	const int activeCount = (int) qPopulationCount( m_history & mask );
+	const int quietCount = m_samples - activeCount;
+
+	const bool wasOn = m_on;
+
+	if( !m_on && activeCount >= m_confirmations )
+	{
+		m_on = true;
+		m_started = time;
+	}
+	else if( m_on && quietCount >= m_confirmations &&
+		time - m_started >= m_minDuration )
+			m_on = false;
+
+	// Samples before the change would confirm the opposite change at once
+	// when N is not more than M / 2.
+	if( m_on != wasOn )
+	{
+		m_history = 0;
+		m_samples = 0;
+	}
+
+	return m_on;
+}
+
+bool
+Hysteresis::isOn() const
+{
+	return m_on;
+}
+
+
+//
+// Tamper
+//
+
+//! Speed of following of slow changes by reference.
+static const qreal c_tamperAdaptation = 0.02;
+
+Tamper::Tamper()
+	:	m_minDeviation( 0.02 )
+	,	m_sharpnessDrop( 0.6 )
+	,	m_lumaChange( 0.3 )
+	,	m_duration( 10000 )
+	,	m_referenceMean( 0.0 )
+	,	m_referenceSharpness( 0.0 )
+	,	m_hasReference( false )
+	,	m_since( -1 )
+	,	m_reasons( None )
+	,	m_tampered( false )
+{
+}
+
+void
+Tamper::setRules( qreal minDeviation, qreal sharpnessDrop, qreal lumaChange,
+	qint64 duration )
+{
+	m_minDeviation = qMax( 0.0, minDeviation );
+	m_sharpnessDrop = qBound( 0.0, sharpnessDrop, 1.0 );
+	m_lumaChange = qMax( 0.0, lumaChange );
+	m_duration = qMax( Q_INT64_C( 0 ), duration );
+}
+
+qreal
+Tamper::minDeviation() const
+{
+	return m_minDeviation;
+}
+
+qreal
+Tamper::sharpnessDrop() const
+{
+	return m_sharpnessDrop;
+}
+
+qreal
+Tamper::lumaChange() const
+{
+	return m_lumaChange;
+}
+
+qint64
+Tamper::duration() const
+{
+	return m_duration;
+}
+
+void
+Tamper::reset()
+{
+	m_referenceMean = 0.0;
+	m_referenceSharpness = 0.0;
+	m_hasReference = false;
+	m_since = -1;
+	m_reasons = None;
+	m_tampered = false;
+}
+
+bool
+Tamper::update( qreal mean, qreal deviation, qreal sharpness, qint64 time )
+{
+	int reasons = None;
+
+	if( deviation < m_minDeviation )
+		reasons |= Covered;
+
+	if( m_hasReference )
+	{
+		if( sharpness >= 0.0 && m_referenceSharpness > 0.0 && m_sharpnessDrop > 0.0 &&
+			sharpness < m_referenceSharpness * ( 1.0 - m_sharpnessDrop ) )
+				reasons |= Defocused;
+
+		if( m_lumaChange > 0.0 && qAbs( mean - m_referenceMean ) > m_lumaChange )
+			reasons |= SceneChanged;
+	}
+
+	// Reported tamper that lasts the duration once more is a permanent
+	// change of the scene, e.g. lights turned off, and becomes the
+	// reference. Covered doesn't depend on reference and stays reported.
+	if( m_tampered && time - m_since >= 2 * m_duration )
+	{
+		m_referenceMean = mean;
+
+		if( sharpness >= 0.0 )
+			m_referenceSharpness = sharpness;
+
+		m_since = time - m_duration;
+
+		reasons &= Covered;
+	}
+
+	if( reasons == None )
+	{
+		if( !m_hasReference )
+		{
+			m_referenceMean = mean;
+			m_referenceSharpness = qMax( 0.0, sharpness );
+			m_hasReference = true;
+		}
+		else
+		{
+			m_referenceMean += ( mean - m_referenceMean ) * c_tamperAdaptation;
+
+			if( sharpness >= 0.0 )
+				m_referenceSharpness += ( sharpness - m_referenceSharpness ) *
+					c_tamperAdaptation;
+		}
+
+		m_since = -1;
+		m_tampered = false;
+
+		return false;
+	}
+
+	if( m_since < 0 )
+		m_since = time;
+
+	m_reasons = reasons;
+
+	if( !m_tampered && time - m_since >= m_duration )
+	{
+		m_tampered = true;
+
+		return true;
+	}
+
+	return false;
+}
+
+bool
+Tamper::isTampered() const
+{
+	return m_tampered;
+}
+
+int
+Tamper::reasons() const
+{
+	return m_reasons;
+}
+
+
+//
+// Detector
+//
+
+//! Limits of gain of compensation of lighting.
+static const qreal c_minGain = 0.25;
+static const qreal c_maxGain = 4.0;
+
+Detector::Detector( qreal threshold )
+	:	m_threshold( threshold )
+	,	m_offThreshold( 0.0 )
+	,	m_active( false )
+	,	m_pixelThreshold( 0.0 )
+	,	m_minBlobArea( 0.0 )
+	,	m_minBlobCount( 1 )
+	,	m_difference( 0.0 )
+	,	m_hasDifference( false )
+	,	m_motion( false )
+	,	m_lightCompensation( false )
+	,	m_lightingThreshold( 0.1 )
+	,	m_lightingChanged( false )
+	,	m_referenceMean( 0.0 )
+	,	m_referenceDeviation( 0.0 )
+	,	m_mean( 0.0 )
+	,	m_deviation( 0.0 )
+	,	m_sharpness( 0.0 )
+{
+	m_clock.start();
+}
+
+qreal
+Detector::threshold() const
+{
+	return m_threshold;
+}
+
+void
+Detector::setThreshold( qreal v )
+{
+	m_threshold = v;
+}
+
+void
+Detector::setBlobRules( qreal pixelThreshold, qreal minArea, int minCount )
+{
+	m_pixelThreshold = pixelThreshold;
+	m_minBlobArea = minArea;
+	m_minBlobCount = qMax( 1, minCount );
+}
+
+qreal
+Detector::pixelThreshold() const
+{
+	return m_pixelThreshold;
+}
+
+qreal
+Detector::minBlobArea() const
+{
+	return m_minBlobArea;
+}
+
+int
+Detector::minBlobCount() const
+{
+	return m_minBlobCount;
+}
+
+void
+Detector::setLightCompensation( bool on, qreal lightingThreshold )
+{
+	m_lightCompensation = on;
+	m_lightingThreshold = lightingThreshold;
+}
+
+bool
+Detector::isLightCompensation() const
+{
+	return m_lightCompensation;
+}
+
+qreal
+Detector::lightingThreshold() const
+{
+	return m_lightingThreshold;
+}
+
+bool
+Detector::lightingChanged() const
+{
+	return m_lightingChanged;
+}
+
+void
+Detector::setOffThreshold( qreal v )
+{
+	m_offThreshold = v;
+}
+
+qreal
+Detector::offThreshold() const
+{
+	return m_offThreshold;
+}
+
+void
+Detector::setHysteresis( int confirmations, int window, qint64 minDuration )
+{
+	m_hysteresis.setRules( confirmations, window, minDuration );
+}
+
+const Hysteresis &
+Detector::hysteresis() const
+{
+	return m_hysteresis;
+}
+
+bool
+Detector::isActive() const
+{
+	return m_active;
+}
+
+void
+Detector::reset()
+{
+	m_reference = QImage();
+	m_map = MotionMap();
+	m_blobs.clear();
+	m_integral = IntegralImage();
+	m_difference = 0.0;
+	m_hasDifference = false;
+	m_motion = false;
+	m_active = false;
+	m_hysteresis.reset();
+	m_lightingChanged = false;
+	m_referenceMean = 0.0;
+	m_referenceDeviation = 0.0;
+	m_mean = 0.0;
+	m_deviation = 0.0;
+	m_sharpness = 0.0;
+}
+
+bool
+Detector::process( const QImage & image )
+{
+	return process( image, m_clock.elapsed() );
+}
+
+bool
+Detector::process( const QImage & image, qint64 time )
+{
+	m_hasDifference = false;
+	m_lightingChanged = false;
+
+	// Statistics are used by compensation of lighting and by the user of
+	// the detector, e.g. for tamper detection.
+	lumaStatistics( image, m_mean, m_deviation, m_sharpness );
+
+	const qreal mean = m_mean;
+	const qreal deviation = m_deviation;
+
+	if( !m_reference.isNull() )
+	{
+		// Size of frames changes only on switch of the format, motion state
+		// is kept till the next comparable frame.
+		bool sample = false;
+		bool hasSample = false;
+
+		if( m_reference.size() == image.size() )
+		{
+			if( m_map.frameSize() != image.size() )
+				m_map.resize( image.size() );
+
+			const int width = image.width();
+			const int height = image.height();
+
+			m_pixels.resize( width * height );
+
+			qreal gain = 1.0;
+			qreal offset = 0.0;
+
+			// Flat reference has no deviation to match.
+			if( m_lightCompensation && m_referenceDeviation > 0.0 )
+			{
+				// Match mean and deviation of luma with the reference.
+				if( deviation > 0.0 )
+					gain = qBound( c_minGain, m_referenceDeviation / deviation,
+						c_maxGain );
+
+				offset = m_referenceMean - mean * gain;
+
+				m_lightingChanged = ( qAbs( mean - m_referenceMean ) >
+					m_lightingThreshold );
+			}
+
+			m_difference = imagesDifference( m_reference, image, m_pixels.data(),
+				gain, offset );
+			m_hasDifference = true;
+
+			m_integral.build( m_pixels.constData(), width, height, width );
+
+			// Cell c covers pixels with x * columns / width == c.
+			const int columns = m_map.columns();
+			const int rows = m_map.rows();
+			float * cells = m_map.differences();
+
+			for( int r = 0; r < rows; ++r )
+			{
+				const int top = ( r * height + rows - 1 ) / rows;
+				const int bottom = ( ( r + 1 ) * height + rows - 1 ) / rows;
+
+				for( int c = 0; c < columns; ++c )
+				{
+					const int left = ( c * width + columns - 1 ) / columns;
+					const int right = ( ( c + 1 ) * width + columns - 1 ) / columns;
+
+					cells[ r * columns + c ] = (float) m_integral.mean(
+						QRect( left, top, right - left, bottom - top ) );
+				}
+			}
+
+			m_map.update( m_threshold );
+
+			if( m_pixelThreshold > 0.0 )
+			{
+				m_mask.resize( width * height );
+
+				for( int i = 0; i < width * height; ++i )
+					m_mask[ i ] = ( m_pixels.at( i ) > m_pixelThreshold ? 1 : 0 );
+
+				m_blobs = findBlobs( m_mask.constData(), image.width(), image.height() );
+
+				const int minArea = qMax( 1, qRound( m_minBlobArea *
+					image.width() * image.height() ) );
+
+				int count = 0;
+
+				for( const auto & b : qAsConst( m_blobs ) )
+				{
+					if( b.m_area >= minArea )
+						++count;
+				}
+
+				sample = ( count >= m_minBlobCount );
+			}
+			else
+				sample = m_difference > ( m_motion && m_offThreshold > 0.0 ?
+					m_offThreshold : m_threshold );
+
+			// Lighting of the whole scene changed, new frame becomes the
+			// reference and motion state is kept.
+			hasSample = !( m_lightCompensation && m_lightingChanged );
+		}
+		else
+			m_map = MotionMap();
+
+		if( hasSample )
+		{
+			m_active = sample;
+			m_motion = m_hysteresis.update( sample, time );
+		}
+	}
+
+	m_reference = image;
+	m_referenceMean = mean;
+	m_referenceDeviation = deviation;
+
+	return m_motion;
+}
+
+bool
+Detector::motion() const
+{
+	return m_motion;
+}
+
+bool
+Detector::hasDifference() const
+{
+	return m_hasDifference;
+}
+
+qreal
+Detector::difference() const
+{
+	return m_difference;
+}
+
+const MotionMap &
+Detector::motionMap() const
+{
+	return m_map;
+}
+
+const QVector< Blob > &
+Detector::blobs() const
+{
+	return m_blobs;
+}
+
+const IntegralImage &
+Detector::differences() const
+{
+	return m_integral;
+}
+
+qreal
+Detector::lumaMean() const
+{
+	return m_mean;
+}
+
+qreal
+Detector::lumaDeviation() const
+{
+	return m_deviation;
+}
+
+qreal
+Detector::lumaSharpness() const
+{
+	return m_sharpness;
+}
+
+} /* namespace SecurityCam */
@@ -0,0 +1,447 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef SECURITYCAM_DETECTOR_HPP_INCLUDED
+#define SECURITYCAM_DETECTOR_HPP_INCLUDED
+
+// Qt include.
+#include <QImage>
+#include <QVector>
+#include <QRect>
+#include <QElapsedTimer>
+
+// SecurityCam include.
+#include "integral.hpp"
+
+
+namespace SecurityCam {
+
+//
+// imagesDifference
+//
+
+//! \return L2 relative error between two images of the same size.
+qreal
+imagesDifference( const QImage & key, const QImage & image );
+
+//! \return L2 relative error between two images of the same size.
+//! In the same pass error of every pixel is written to pixels, row by row,
+//! if not null.
+qreal
+imagesDifference( const QImage & key, const QImage & image, float * pixels );
+
+//! \return L2 relative error between two images of the same size, channels
+//! of image are corrected as c * gain + offset before comparison.
+//! In the same pass error of every pixel is written to pixels, if not null.
+qreal
+imagesDifference( const QImage & key, const QImage & image, float * pixels,
+	qreal gain, qreal offset );
+
+
+//
+// lumaStatistics
+//
+
+//! Calculate mean and standard deviation of luma of the image, from 0 to 1,
+//! sampled on a coarse grid.
+void
+lumaStatistics( const QImage & image, qreal & mean, qreal & deviation );
+
+//! Calculate mean and standard deviation of luma of the image and variance of
+//! Laplacian of luma, see sharpness(), in one pass over the same samples.
+void
+lumaStatistics( const QImage & image, qreal & mean, qreal & deviation,
+	qreal & laplacian );
+
+
+//
+// Blob
+//
+
+//! Connected region of set pixels of the mask.
+struct Blob {
+	//! Area in pixels.
+	int m_area;
+	//! Bounding box.
+	QRect m_rect;
+}; // struct Blob
+
+
+//
+// findBlobs
+//
+
+//! \return 4-connected regions of non-zero pixels of the mask, labelled in
+//! one pass with union-find.
+QVector< Blob >
+findBlobs( const uchar * mask, int width, int height );
+
+
+//
+// sharpness
+//
+
+//! \return Variance of Laplacian of luma, sampled on a coarse grid. Luma of
+//! pixel x is at luma[ x * pixelStride ].
+qreal
+sharpness( const uchar * luma, int width, int height, int bytesPerLine,
+	int pixelStride );
+
+
+//
+// fingerprint
+//
+
+//! Size of the side of the fingerprint's grid.
+static const int c_fingerprintSize = 16;
+
+//! \return Fingerprint of the image, mean luma of cells of the
+//! c_fingerprintSize x c_fingerprintSize grid.
+QByteArray
+fingerprint( const QImage & image );
+
+//! \return Mean absolute difference of fingerprints, from 0 to 1,
+//! or 1 if fingerprints are not comparable.
+qreal
+fingerprintDifference( const QByteArray & f1, const QByteArray & f2 );
+
+
+//
+// MotionMap
+//
+
+//! Low resolution map of motion, updated on every key frame.
+class MotionMap final {
+public:
+	//! Maximum count of columns.
+	static const int c_maxColumns = 64;
+
+	MotionMap();
+
+	//! \return Is map empty.
+	bool isEmpty() const;
+
+	//! Resize the map for the given frame size, map is cleared.
+	void resize( const QSize & frameSize );
+	//! \return Size of the frame.
+	const QSize & frameSize() const;
+
+	//! \return Count of columns.
+	int columns() const;
+	//! \return Count of rows.
+	int rows() const;
+
+	//! \return Mean difference of cells.
+	float * differences();
+	//! \return Mean difference of cells.
+	const float * differences() const;
+
+	//! Update mask, heat and boxes with new differences.
+	void update( qreal threshold );
+
+	//! \return Is motion in the cell.
+	bool isMotion( int column, int row ) const;
+	//! \return Heat of the cell, from 0 to 255.
+	int heat( int column, int row ) const;
+	//! \return Fraction of cells with motion.
+	qreal coverage() const;
+	//! \return Bounding boxes of connected cells with motion, in cells.
+	const QVector< QRect > & boxes() const;
+
+	//! \return Overlay with heat and mask, one pixel per cell.
+	QImage overlay() const;
+
+private:
+	//! Size of the frame.
+	QSize m_frameSize;
+	//! Columns.
+	int m_columns;
+	//! Rows.
+	int m_rows;
+	//! Differences.
+	QVector< float > m_diff;
+	//! Mask.
+	QVector< uchar > m_mask;
+	//! Heat.
+	QVector< uchar > m_heat;
+	//! Boxes.
+	QVector< QRect > m_boxes;
+}; // class MotionMap
+
+
+//
+// Hysteresis
+//
+
+//! State machine of motion event. Event starts when at least N of the last
+//! M samples are active, and ends when at least N of the last M samples are
+//! quiet, but not earlier than minimum duration after start. Only samples
+//! taken since the last change of state are counted.
+class Hysteresis final {
+public:
+	//! Maximum size of the window.
+	static const int c_maxWindow = 64;
+
+	Hysteresis();
+
+	//! Set rules.
+	void setRules( int confirmations, int window, qint64 minDuration );
+	//! \return Count of samples to confirm change of state, N.
+	int confirmations() const;
+	//! \return Count of the last samples, M.
+	int window() const;
+	//! \return Minimum duration of the event, in milliseconds.
+	qint64 minDuration() const;
+
+	//! Forget samples, event ends.
+	void reset();
+
+	//! Add sample taken at the time in milliseconds. \return Is event on.
+	bool update( bool active, qint64 time );
+
+	//! \return Is event on.
+	bool isOn() const;
+
+private:
+	//! N.
+	int m_confirmations;
+	//! M.
+	int m_window;
+	//! Minimum duration.
+	qint64 m_minDuration;
+	//! Bits of the last samples since change of state, the newest is the
+	//! lowest.
+	quint64 m_history;
+	//! Count of samples in history.
+	int m_samples;
+	//! Is event on.
+	bool m_on;
+	//! Time of start of the event.
+	qint64 m_started;
+}; // class Hysteresis
+
+
+//
+// Tamper
+//
+
+//! Detector of tampering of the camera from statistics of key frames.
+//! Camera is covered when deviation of luma collapses, defocused when
+//! sharpness drops below the reference, and turned away when mean luma
+//! moves away from the reference. Tamper is reported when any of these
+//! lasts at least the given duration. Reference follows slow changes of
+//! the scene while there is no tamper, and is replaced with the current
+//! statistics when reported tamper lasts the duration once more, so
+//! permanent changes of the scene are learned.
+class Tamper final {
+public:
+	//! Reason of tamper.
+	enum Reason {
+		//! No tamper.
+		None = 0,
+		//! Lens is covered or painted.
+		Covered = 1,
+		//! Lens is defocused.
+		Defocused = 2,
+		//! Camera is turned away.
+		SceneChanged = 4
+	}; // enum Reason
+
+	Tamper();
+
+	//! Set rules. Luma and its deviation are from 0 to 1, sharpnessDrop is a
+	//! fraction of reference sharpness, duration is in milliseconds.
+	void setRules( qreal minDeviation, qreal sharpnessDrop, qreal lumaChange,
+		qint64 duration );
+	//! \return Minimum deviation of luma.
+	qreal minDeviation() const;
+	//! \return Drop of sharpness.
+	qreal sharpnessDrop() const;
+	//! \return Change of mean luma.
+	qreal lumaChange() const;
+	//! \return Duration of tamper before it's reported.
+	qint64 duration() const;
+
+	//! Forget reference and tamper.
+	void reset();
+
+	//! Add statistics of key frame taken at the time in milliseconds, negative
+	//! sharpness is unknown. \return Is tamper detected on this frame, only
+	//! once per tamper.
+	bool update( qreal mean, qreal deviation, qreal sharpness, qint64 time );
+
+	//! \return Is tamper in progress.
+	bool isTampered() const;
+	//! \return Reasons of the last tamper, combination of Reason.
+	int reasons() const;
+
+private:
+	//! Minimum deviation of luma.
+	qreal m_minDeviation;
+	//! Drop of sharpness.
+	qreal m_sharpnessDrop;
+	//! Change of mean luma.
+	qreal m_lumaChange;
+	//! Duration.
+	qint64 m_duration;
+	//! Reference mean of luma.
+	qreal m_referenceMean;
+	//! Reference sharpness.
+	qreal m_referenceSharpness;
+	//! Is reference set.
+	bool m_hasReference;
+	//! Time of the start of suspicious frames, -1 if there are no such.
+	qint64 m_since;
+	//! Reasons.
+	int m_reasons;
+	//! Is tamper reported.
+	bool m_tampered;
+}; // class Tamper
+
+
+//
+// Detector
+//
+
+//! Motion detector. Compares every new key frame with the previous one.
+class Detector final {
+public:
+	explicit Detector( qreal threshold = 0.02 );
+
+	//! \return Threshold.
+	qreal threshold() const;
+	//! Set threshold.
+	void setThreshold( qreal v );
+
+	//! Forget reference frame and motion state.
+	void reset();
+
+	//! Set rules of blobs. Pixels with difference above pixelThreshold are
+	//! joined in blobs, motion is detected if there are at least minCount
+	//! blobs with area at least minArea of the frame. Zero pixelThreshold
+	//! disables blobs, then mean difference is compared with threshold.
+	void setBlobRules( qreal pixelThreshold, qreal minArea, int minCount );
+	//! \return Threshold of difference of pixel for blobs.
+	qreal pixelThreshold() const;
+	//! \return Minimum area of the blob, fraction of the frame.
+	qreal minBlobArea() const;
+	//! \return Minimum count of blobs.
+	int minBlobCount() const;
+
+	//! Enable or disable compensation of global changes of lighting. Mean and
+	//! deviation of luma of new frame are matched with the reference, and
+	//! jump of mean luma above lightingThreshold is a change of lighting of
+	//! the scene, not a motion.
+	void setLightCompensation( bool on, qreal lightingThreshold );
+	//! \return Is compensation of lighting enabled.
+	bool isLightCompensation() const;
+	//! \return Jump of mean luma that is a change of lighting.
+	qreal lightingThreshold() const;
+	//! \return Was lighting of the scene changed on the last processed frame.
+	bool lightingChanged() const;
+
+	//! Set threshold of end of motion, 0 means the same as threshold.
+	//! Used only with mean difference, without blobs.
+	void setOffThreshold( qreal v );
+	//! \return Threshold of end of motion.
+	qreal offThreshold() const;
+
+	//! Set N-of-M confirmation of start and end of motion and minimum
+	//! duration of motion in milliseconds.
+	void setHysteresis( int confirmations, int window, qint64 minDuration );
+	//! \return Hysteresis.
+	const Hysteresis & hysteresis() const;
+
+	//! Process new key frame. \return Is motion detected.
+	bool process( const QImage & image );
+	//! Process new key frame taken at the time in milliseconds.
+	//! \return Is motion detected.
+	bool process( const QImage & image, qint64 time );
+
+	//! \return Was the last processed frame active, before hysteresis.
+	bool isActive() const;
+
+	//! \return Is motion in progress.
+	bool motion() const;
+
+	//! \return Was difference calculated on the last processed frame.
+	bool hasDifference() const;
+	//! \return Difference calculated on the last processed frame.
+	qreal difference() const;
+
+	//! \return Map of motion.
+	const MotionMap & motionMap() const;
+
+	//! \return Blobs found on the last processed frame.
+	const QVector< Blob > & blobs() const;
+
+	//! \return Summed-area table of differences of pixels of the last
+	//! processed frame.
+	const IntegralImage & differences() const;
+
+	//! \return Mean of luma of the last processed frame, from 0 to 1.
+	qreal lumaMean() const;
+	//! \return Standard deviation of luma of the last processed frame.
+	qreal lumaDeviation() const;
+	//! \return Sharpness of the last processed frame, see sharpness().
+	qreal lumaSharpness() const;
+
+private:
+	//! Reference frame.
+	QImage m_reference;
+	//! Map of motion.
+	MotionMap m_map;
+	//! Threshold.
+	qreal m_threshold;
+	//! Threshold of end of motion.
+	qreal m_offThreshold;
+	//! Hysteresis.
+	Hysteresis m_hysteresis;
+	//! Clock of frames without time.
+	QElapsedTimer m_clock;
+	//! Was the last frame active.
+	bool m_active;
+	//! Threshold of difference of pixel.
+	qreal m_pixelThreshold;
+	//! Minimum area of the blob.
+	qreal m_minBlobArea;
+	//! Minimum count of blobs.
+	int m_minBlobCount;
+	//! Differences of pixels.
+	QVector< float > m_pixels;
+	//! Summed-area table of differences.
+	IntegralImage m_integral;
+	//! Mask of pixels with motion.
+	QVector< uchar > m_mask;
+	//! Blobs.
+	QVector< Blob > m_blobs;
+	//! Last difference.
+	qreal m_difference;
+	//! Has difference.
+	bool m_hasDifference;
+	//! Motion.
+	bool m_motion;
+	//! Compensation of lighting.
+	bool m_lightCompensation;
+	//! Jump of mean luma that is a change of lighting.
+	qreal m_lightingThreshold;
+	//! Lighting changed.
+	bool m_lightingChanged;
+	//! Mean luma of the reference.
+	qreal m_referenceMean;
+	//! Deviation of luma of the reference.
+	qreal m_referenceDeviation;
+	//! Mean luma of the last frame.
+	qreal m_mean;
+	//! Deviation of luma of the last frame.
+	qreal m_deviation;
+	//! Sharpness of the last frame.
+	qreal m_sharpness;
+}; // class Detector
+
+} /* namespace SecurityCam */
+
+#endif // SECURITYCAM_DETECTOR_HPP_INCLUDED
@@ -0,0 +1,120 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include "devices.hpp"
+#include "resolution.hpp"
+
+// Qt include.
+#include <QMediaDevices>
+#include <QCoreApplication>
+
+
+namespace SecurityCam {
+
+//
+// Devices
+//
+
+//! Instance, owned by the application object.
+static Devices * s_devices = nullptr;
+
+//! Delete instance while the application object is still alive.
+static void
+deleteDevices()
+{
+	delete s_devices;
+}
+
+Devices::Devices()
+	:	QObject( QCoreApplication::instance() )
+	,	m_devices( nullptr )
+	,	m_valid( false )
+{
+}
+
+Devices::~Devices()
+{
+	s_devices = nullptr;
+}
+
+Devices &
+Devices::instance()
+{
+	Q_ASSERT( QCoreApplication::instance() );
+
+	if( !s_devices )
+	{
+		s_devices = new Devices;
+
+		qAddPostRoutine( deleteDevices );
+	}
+
+	return *s_devices;
+}
+
+QList< QCameraDevice >
+Devices::cameras()
+{
+	if( !m_devices )
+	{
+		m_devices = new QMediaDevices( this );
+
+		connect( m_devices, &QMediaDevices::videoInputsChanged,
+			this, &Devices::invalidate );
+	}
+
+	if( !m_valid )
+	{
+		m_cameras = QMediaDevices::videoInputs();
+		m_valid = true;
+	}
+
+	return m_cameras;
+}
+
+QCameraDevice
+Devices::camera( const QString & description )
+{
+	const auto list = cameras();
+
+	for( const auto & c : list )
+	{
+		if( c.description() == description )
+			return c;
+	}
+
+	return QCameraDevice();
+}
+
+QCameraFormat
+Devices::format( const QCameraDevice & dev, const Cfg::Resolution & r )
+{
+	const QString key = QString::fromLatin1( dev.id() ) +
+		QStringLiteral( "/%1x%2@%3:" ).arg( r.width() ).arg( r.height() )
+			.arg( r.fps() ) + r.format();
+
+	const auto it = m_formats.constFind( key );
+
+	if( it != m_formats.cend() )
+		return it.value();
+
+	const QCameraFormat fmt = findCameraFormat( dev, r );
+
+	m_formats.insert( key, fmt );
+
+	return fmt;
+}
+
+void
+Devices::invalidate()
+{
+	m_valid = false;
+	m_cameras.clear();
+	m_formats.clear();
+}
+
+} /* namespace SecurityCam */
@@ -0,0 +1,77 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef SECURITYCAM_DEVICES_HPP_INCLUDED
+#define SECURITYCAM_DEVICES_HPP_INCLUDED
+
+// Qt include.
+#include <QObject>
+#include <QCameraDevice>
+#include <QCameraFormat>
+#include <QList>
+#include <QHash>
+
+// SecurityCam include.
+#include "cfg.hpp"
+
+QT_BEGIN_NAMESPACE
+class QMediaDevices;
+QT_END_NAMESPACE
+
+
+namespace SecurityCam {
+
+//
+// Devices
+//
+
+//! Cache of cameras and of their formats resolved from configured
+//! resolutions. Cameras are enumerated on first request, not on start, and
+//! again after the list of devices changes. Should be used in GUI thread
+//! after the application object is created. Instance is a child of the
+//! application object and is deleted in its destructor, before multimedia
+//! is torn down.
+class Devices final
+	:	public QObject
+{
+	Q_OBJECT
+
+public:
+	//! \return Instance.
+	static Devices & instance();
+
+	//! \return Cameras.
+	QList< QCameraDevice > cameras();
+	//! \return Camera with the given description, null device if there is
+	//! no such one.
+	QCameraDevice camera( const QString & description );
+	//! \return Format of the camera that matches the configured resolution,
+	//! or null format if there is no such one.
+	QCameraFormat format( const QCameraDevice & dev, const Cfg::Resolution & r );
+
+private slots:
+	//! List of devices changed.
+	void invalidate();
+
+private:
+	Devices();
+	~Devices() override;
+
+	Q_DISABLE_COPY( Devices )
+
+	//! Media devices, created with the first enumeration.
+	QMediaDevices * m_devices;
+	//! Is list of cameras valid.
+	bool m_valid;
+	//! Cameras.
+	QList< QCameraDevice > m_cameras;
+	//! Resolved formats by device and resolution.
+	QHash< QString, QCameraFormat > m_formats;
+}; // class Devices
+
+} /* namespace SecurityCam */
+
+#endif // SECURITYCAM_DEVICES_HPP_INCLUDED
@@ -0,0 +1,234 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include "formatcost.hpp"
+#include "detector.hpp"
+#include "frames.hpp"
+#include "convert.hpp"
+#include "scale.hpp"
+
+// Qt include.
+#include <QVideoFrame>
+#include <QVideoFrameFormat>
+#include <QElapsedTimer>
+#include <QBuffer>
+#include <QImage>
+
+
+namespace SecurityCam {
+
+//! Count of timed runs, the fastest one is taken.
+static const int c_runs = 3;
+
+//! FPS above which quality doesn't grow.
+static const qreal c_maxUsefulFps = 30.0;
+
+
+//
+// measureFormatCost
+//
+
+//! Fill synthetic frame with the pattern, so conversion is not trivial.
+static void
+fillFrame( QVideoFrame & frame )
+{
+	if( !frame.map( QVideoFrame::WriteOnly ) )
+		return;
+
+	for( int p = 0; p < frame.planeCount(); ++p )
+	{
+		uchar * bits = frame.bits( p );
+		const int bytes = frame.mappedBytes( p );
+
+		for( int i = 0; i < bytes; ++i )
+			bits[ i ] = (uchar) ( ( i * 31 + p * 17 ) ^ ( i >> 8 ) );
+	}
+
+	frame.unmap();
+}
+
+//! \return Synthetic image of the given size.
+static QImage
+pattern( const QSize & size )
+{
+	QImage image( size, QImage::Format_RGB32 );
+
+	for( int y = 0; y < size.height(); ++y )
+	{
+		QRgb * line = reinterpret_cast< QRgb* > ( image.scanLine( y ) );
+
+		for( int x = 0; x < size.width(); ++x )
+			line[ x ] = qRgb( x * 7 + y, x ^ y, y * 5 - x );
+	}
+
+	return image;
+}
+
+//! \return The fastest time.
+static qint64
+fastest( qint64 best, qint64 t )
+{
+	return ( best < 0 ? t : qMin( best, t ) );
+}
+
+FormatCost
+measureFormatCost( const QCameraFormat & format, const Detector & detector,
+	int detectionWidth )
+{
+	FormatCost res;
+	res.m_format = format;
+	res.m_supported = false;
+	res.m_mapTime = 0.0;
+	res.m_convertTime = 0.0;
+	res.m_detectTime = 0.0;
+	res.m_cpu = 0.0;
+
+	const QSize size = format.resolution();
+
+	if( size.isEmpty() )
+		return res;
+
+	// Key frames are converted at the size of analysis, see
+	// Frames::analysisSize().
+	QSize analysed = size;
+
+	if( detectionWidth > 0 && size.width() > detectionWidth )
+		analysed = size.scaled( QSize( detectionWidth, size.height() ),
+			Qt::KeepAspectRatio );
+
+	QElapsedTimer timer;
+	QImage image;
+	qint64 map = 0;
+	qint64 convert = -1;
+
+	if( format.pixelFormat() == QVideoFrameFormat::Format_Jpeg )
+	{
+		// Mapping of compressed frame doesn't decode it.
+		QByteArray data;
+		QBuffer buffer( &data );
+		buffer.open( QIODevice::WriteOnly );
+		pattern( size ).save( &buffer, "JPG" );
+
+		for( int i = 0; i < c_runs; ++i )
+		{
+			timer.start();
+			image = scaleToSize( QImage::fromData( data, "JPG" ), analysed );
+			convert = fastest( convert, timer.nsecsElapsed() );
+		}
+	}
+	else
+	{
+		QVideoFrame frame( QVideoFrameFormat( size, format.pixelFormat() ) );
+
+		if( !frame.isValid() )
+			return res;
+
+		fillFrame( frame );
+
+		map = -1;
+
+		for( int i = 0; i < c_runs; ++i )
+		{
+			timer.start();
+			frame.map( QVideoFrame::ReadOnly );
+			frame.unmap();
+			map = fastest( map, timer.nsecsElapsed() );
+		}
+
+		// Key frame is converted while mapped.
+		if( !frame.map( QVideoFrame::ReadOnly ) )
+			return res;
+
+		for( int i = 0; i < c_runs; ++i )
+		{
+			timer.start();
+			image = frameToImage( frame, analysed );
+			convert = fastest( convert, timer.nsecsElapsed() );
+		}
+
+		frame.unmap();
+	}
+
+	if( image.isNull() )
+		return res;
+
+	const QImage frames[ 2 ] = { image, image.mirrored() };
+
+	Detector d = detector;
+	d.reset();
+	d.process( frames[ 1 ] );
+
+	qint64 detect = -1;
+
+	for( int i = 0; i < c_runs; ++i )
+	{
+		// Frame is decimated if conversion didn't scale it exactly.
+		timer.start();
+		d.process( scaleToSize( frames[ i % 2 ], analysed ) );
+		detect = fastest( detect, timer.nsecsElapsed() );
+	}
+
+	const qreal fps = qMax( (qreal) format.maxFrameRate(), (qreal) 1.0 );
+
+	res.m_supported = true;
+	res.m_mapTime = map / 1000000.0;
+	res.m_convertTime = convert / 1000000.0;
+	res.m_detectTime = detect / 1000000.0;
+	res.m_cpu = ( fps * res.m_mapTime + fps / c_keyFrameChangesOn *
+		( res.m_convertTime + res.m_detectTime ) ) / 1000.0;
+
+	return res;
+}
+
+
+//
+// chooseFormat
+//
+
+//! \return Quality of the format.
+static qreal
+quality( const QCameraFormat & f )
+{
+	return (qreal) f.resolution().width() * f.resolution().height() *
+		qMin( (qreal) f.maxFrameRate(), c_maxUsefulFps );
+}
+
+int
+chooseFormat( const QVector< FormatCost > & costs, qreal budget )
+{
+	int best = -1;
+	int cheapest = -1;
+
+	for( int i = 0; i < costs.size(); ++i )
+	{
+		const auto & c = costs.at( i );
+
+		if( !c.m_supported )
+			continue;
+
+		if( cheapest < 0 || c.m_cpu < costs.at( cheapest ).m_cpu )
+			cheapest = i;
+
+		if( c.m_cpu > budget )
+			continue;
+
+		if( best < 0 )
+			best = i;
+		else
+		{
+			const qreal q1 = quality( c.m_format );
+			const qreal q2 = quality( costs.at( best ).m_format );
+
+			if( q1 > q2 || ( q1 == q2 && c.m_cpu < costs.at( best ).m_cpu ) )
+				best = i;
+		}
+	}
+
+	return ( best >= 0 ? best : cheapest );
+}
+
+} /* namespace SecurityCam */
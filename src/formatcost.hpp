@@ -0,0 +1,66 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef SECURITYCAM_FORMATCOST_HPP_INCLUDED
+#define SECURITYCAM_FORMATCOST_HPP_INCLUDED
+
+// Qt include.
+#include <QCameraFormat>
+#include <QVector>
+
+
+namespace SecurityCam {
+
+class Detector;
+
+//
+// FormatCost
+//
+
+//! Cost of processing of frames of the camera format on this machine.
+struct FormatCost {
+	//! Format.
+	QCameraFormat m_format;
+	//! Is frames of the format can be converted to image.
+	bool m_supported;
+	//! Time of mapping of every frame, in milliseconds.
+	qreal m_mapTime;
+	//! Time of conversion of the key frame to image at the detection width,
+	//! in milliseconds.
+	qreal m_convertTime;
+	//! Time of detection on the key frame, in milliseconds.
+	qreal m_detectTime;
+	//! Load of the one core at maximum FPS, 1.0 is 100%.
+	qreal m_cpu;
+}; // struct FormatCost
+
+
+//
+// measureFormatCost
+//
+
+//! Run timed mapping, conversion and detection on synthetic frames of the
+//! format like the pipeline does: every frame is mapped, and one key frame
+//! of c_keyFrameChangesOn is converted at \a detectionWidth, 0 means full
+//! resolution, and is processed with a copy of \a detector. Preview is not
+//! counted. Safe to call in any thread.
+FormatCost
+measureFormatCost( const QCameraFormat & format, const Detector & detector,
+	int detectionWidth );
+
+
+//
+// chooseFormat
+//
+
+//! \return Index of the format with the best quality within CPU budget,
+//! or of the cheapest one if no format fits. -1 if nothing is supported.
+int
+chooseFormat( const QVector< FormatCost > & costs, qreal budget );
+
+} /* namespace SecurityCam */
+
+#endif // SECURITYCAM_FORMATCOST_HPP_INCLUDED
@@ -13,16 +13,103 @@
 // Qt include.
 #include <QMutexLocker>
 #include <QTimer>
-#include <QMediaDevices>
 #include <QDateTime>
 #include <QDir>
 #include <QImageCapture>
+#include <QElapsedTimer>
+#include <QBuffer>
+#include <QFile>
+
+// SecurityCam include.
+#include "trace.hpp"
+#include "resolution.hpp"
+#include "scale.hpp"
+#include "convert.hpp"
+#include "devices.hpp"
+
+// C++ include.
+#include <cmath>
 
 
 namespace SecurityCam {
 
 static const int c_noFramesTimeout = 3000;
 
+//! First delay of reconnect of the camera.
+static const int c_minReconnectDelay = 1000;
+
+//! Maximum delay of reconnect of the camera.
+static const int c_maxReconnectDelay = 60000;
+
+
+//
+// frameSharpness
+//
+
+//! \return Sharpness of luma of the mapped frame, -1 if luma of the format
+//! is not accessible without conversion.
+static qreal
+frameSharpness( const QVideoFrame & f )
+{
+	int offset = 0;
+	int stride = 1;
+
+	switch( f.pixelFormat() )
+	{
+		case QVideoFrameFormat::Format_YUV420P :
+		case QVideoFrameFormat::Format_YUV422P :
+		case QVideoFrameFormat::Format_YV12 :
+		case QVideoFrameFormat::Format_NV12 :
+		case QVideoFrameFormat::Format_NV21 :
+		case QVideoFrameFormat::Format_IMC1 :
+		case QVideoFrameFormat::Format_IMC2 :
+		case QVideoFrameFormat::Format_IMC3 :
+		case QVideoFrameFormat::Format_IMC4 :
+		case QVideoFrameFormat::Format_Y8 :
+			break;
+
+		case QVideoFrameFormat::Format_YUYV :
+			stride = 2;
+			break;
+
+		case QVideoFrameFormat::Format_UYVY :
+			offset = 1;
+			stride = 2;
+			break;
+
+		case QVideoFrameFormat::Format_AYUV :
+		case QVideoFrameFormat::Format_AYUV_Premultiplied :
+			offset = 1;
+			stride = 4;
+			break;
+
+		// Green is close enough to luma.
+		case QVideoFrameFormat::Format_ARGB8888 :
+		case QVideoFrameFormat::Format_ARGB8888_Premultiplied :
+		case QVideoFrameFormat::Format_XRGB8888 :
+		case QVideoFrameFormat::Format_ABGR8888 :
+		case QVideoFrameFormat::Format_XBGR8888 :
+			offset = 2;
+			stride = 4;
+			break;
+
+		case QVideoFrameFormat::Format_BGRA8888 :
+		case QVideoFrameFormat::Format_BGRA8888_Premultiplied :
+		case QVideoFrameFormat::Format_BGRX8888 :
+		case QVideoFrameFormat::Format_RGBA8888 :
+		case QVideoFrameFormat::Format_RGBX8888 :
+			offset = 1;
+			stride = 4;
+			break;
+
+		default :
+			return -1.0;
+	}
+
+	return sharpness( f.bits( 0 ) + offset, f.width(), f.height(),
+		f.bytesPerLine( 0 ), stride );
+}
+
 
 //
 // Frames
@@ -32,24 +119,77 @@ Frames::Frames( const Cfg::Cfg & cfg, QObject * parent )
 	:	QVideoSink( parent )
 	,	m_cam( nullptr )
 	,	m_counter( 0 )
-	,	m_keyFrameCounter( 0 )
-	,	m_motion( false )
+	,	m_transformApplied( false )
+	,	m_detector( cfg.threshold() )
 	,	m_threshold( cfg.threshold() )
+	,	m_dayThreshold( cfg.dayThreshold() )
+	,	m_nightThreshold( cfg.nightThreshold() )
+	,	m_tamperDetection( cfg.tamperDetection() )
+	,	m_profile( Calibration::Day )
+	,	m_calibrating( false )
+	,	m_calibrationTimer( new QTimer( this ) )
+	,	m_rollingTimer( new QTimer( this ) )
 	,	m_rotation( cfg.rotation() )
 	,	m_mirrored( cfg.mirrored() )
+	,	m_detectionWidth( cfg.detectionWidth() )
 	,	m_timer( new QTimer( this ) )
 	,	m_secTimer( new QTimer( this ) )
 	,	m_fps( 0 )
+	,	m_analysedFps( 0 )
+	,	m_metrics( nullptr )
+	,	m_frameId( 0 )
+	,	m_frameTime( -1 )
+	,	m_previewEnabled( true )
+	,	m_previewInterval( 0 )
 	,	m_imgCapture( nullptr )
+	,	m_camStarted( -1 )
+	,	m_reconnectTimer( new QTimer( this ) )
+	,	m_reconnectDelay( c_minReconnectDelay )
+	,	m_outageStarted( -1 )
+	,	m_idleResolution( cfg.idleResolution() )
+	,	m_idleTimeout( cfg.idleTimeout() )
+	,	m_idleTimer( new QTimer( this ) )
+	,	m_idle( false )
+	,	m_switching( false )
+	,	m_capturePending( false )
+	,	m_bestFrame( cfg.bestFrame() )
+	,	m_window( false )
+	,	m_bestScore( -1.0 )
+	,	m_bestId( -1 )
+	,	m_duplicateEpsilon( cfg.duplicateEpsilon() )
 {
+	m_detector.setBlobRules( cfg.blobThreshold(), cfg.minBlobArea(),
+		cfg.minBlobCount() );
+	m_detector.setLightCompensation( cfg.lightCompensation(),
+		cfg.lightingThreshold() );
+	m_detector.setOffThreshold( cfg.offThreshold() );
+	m_tamper.setRules( cfg.tamperDeviation(), cfg.tamperSharpnessDrop(),
+		cfg.tamperLumaChange(), cfg.tamperDuration() );
+	m_detector.setHysteresis( cfg.motionConfirmations(), cfg.motionWindow(),
+		cfg.minEventDuration() );
+
 	if( cfg.applyTransform() )
 		applyTransform();
 
 	m_timer->setInterval( c_noFramesTimeout );
 	m_secTimer->setInterval( 1000 );
+	m_idleTimer->setSingleShot( true );
+	m_calibrationTimer->setSingleShot( true );
+	m_reconnectTimer->setSingleShot( true );
+
+	m_calibration.setRules( cfg.calibrationPercentile(), cfg.calibrationMargin(),
+		cfg.nightLuma() );
+	setRollingCalibration( cfg.calibrationInterval() );
+	applyThreshold();
 
 	connect( m_timer, &QTimer::timeout, this, &Frames::noFramesTimeout );
 	connect( m_secTimer, &QTimer::timeout, this, &Frames::second );
+	connect( m_idleTimer, &QTimer::timeout, this, &Frames::enterIdle );
+	connect( m_reconnectTimer, &QTimer::timeout, this, &Frames::reconnect );
+	connect( m_calibrationTimer, &QTimer::timeout,
+		this, &Frames::finishCalibration );
+	connect( m_rollingTimer, &QTimer::timeout,
+		this, &Frames::finishCalibration );
 	connect( this, &QVideoSink::videoFrameChanged, this, &Frames::frame );
 
 	m_secTimer->start();
@@ -89,7 +229,7 @@ Frames::threshold() const
 {
 	QMutexLocker lock( &m_mutex );
 
-	return m_threshold;
+	return m_detector.threshold();
 }
 
 void
@@ -98,6 +238,122 @@ Frames::setThreshold( qreal v )
 	QMutexLocker lock( &m_mutex );
 
 	m_threshold = v;
+
+	applyThreshold();
+}
+
+void
+Frames::applyThreshold()
+{
+	const qreal t = ( m_profile == Calibration::Night ? m_nightThreshold :
+		m_dayThreshold );
+
+	m_detector.setThreshold( t > 0.0 ? t : m_threshold );
+}
+
+void
+Frames::setProfileThresholds( qreal day, qreal night )
+{
+	QMutexLocker lock( &m_mutex );
+
+	m_dayThreshold = day;
+	m_nightThreshold = night;
+
+	applyThreshold();
+}
+
+void
+Frames::setCalibrationRules( qreal percentile, qreal margin, qreal nightLuma )
+{
+	m_calibration.setRules( percentile, margin, nightLuma );
+}
+
+bool
+Frames::isCalibrating() const
+{
+	return m_calibrating;
+}
+
+void
+Frames::startCalibration( int secs )
+{
+	m_calibration.clear();
+	m_calibrating = true;
+
+	m_calibrationTimer->start( qMax( 1, secs ) * 1000 );
+}
+
+void
+Frames::setRollingCalibration( int minutes )
+{
+	if( minutes > 0 )
+	{
+		if( m_rollingTimer->interval() != minutes * 60 * 1000 ||
+			!m_rollingTimer->isActive() )
+				m_rollingTimer->start( minutes * 60 * 1000 );
+	}
+	else
+		m_rollingTimer->stop();
+}
+
+void
+Frames::finishCalibration()
+{
+	const qreal day = m_calibration.threshold( Calibration::Day );
+	const qreal night = m_calibration.threshold( Calibration::Night );
+
+	m_calibrating = false;
+	m_calibrationTimer->stop();
+	m_calibration.clear();
+
+	{
+		QMutexLocker lock( &m_mutex );
+
+		if( day > 0.0 )
+			m_dayThreshold = day;
+
+		if( night > 0.0 )
+			m_nightThreshold = night;
+
+		applyThreshold();
+	}
+
+	emit calibrated( day, night );
+}
+
+void
+Frames::setBlobRules( qreal pixelThreshold, qreal minArea, int minCount )
+{
+	QMutexLocker lock( &m_mutex );
+
+	m_detector.setBlobRules( pixelThreshold, minArea, minCount );
+}
+
+void
+Frames::setLightCompensation( bool on, qreal lightingThreshold )
+{
+	QMutexLocker lock( &m_mutex );
+
+	m_detector.setLightCompensation( on, lightingThreshold );
+}
+
+void
+Frames::setTamperDetection( bool on, qreal minDeviation, qreal sharpnessDrop,
+	qreal lumaChange, int duration )
+{
+	m_tamperDetection = on;
+	m_tamper.setRules( minDeviation, sharpnessDrop, lumaChange, duration );
+	m_tamper.reset();
+}
+
+void
+Frames::setHysteresis( qreal offThreshold, int confirmations, int window,
+	int minDuration )
+{
+	QMutexLocker lock( &m_mutex );
+
+	m_detector.setOffThreshold( offThreshold );
+	m_detector.setHysteresis( confirmations, window, minDuration );
 }
 
 void
@@ -107,6 +363,8 @@ Frames::applyTransform( bool on )
 
 	if( on )
 	{
+		m_transformApplied = false;
+
 		m_transform = QTransform();
 
 		m_transform.rotate( m_rotation );
@@ -129,15 +387,168 @@ Frames::applyTransform( bool on )
 	}
 }
 
+int
+Frames::detectionWidth() const
+{
+	return m_detectionWidth;
+}
+
+void
+Frames::setDetectionWidth( int w )
+{
+	m_detectionWidth = qMax( 0, w );
+}
+
+Detector
+Frames::detector() const
+{
+	QMutexLocker lock( &m_mutex );
+
+	Detector d = m_detector;
+	d.reset();
+
+	return d;
+}
+
+QImage
+Frames::transformed( const QImage & image ) const
+{
+	return ( m_transformApplied ? image.transformed( m_transform ) : image.copy() );
+}
+
 QCameraFormat
 Frames::cameraFormat() const
 {
 	if( m_cam )
-		return m_cam->cameraFormat();
+		return ( m_format.isNull() ? m_cam->cameraFormat() : m_format );
 	else
 		return QCameraFormat();
 }
 
+bool
+Frames::isBestFrame() const
+{
+	return m_bestFrame;
+}
+
+void
+Frames::setBestFrame( bool on )
+{
+	if( m_bestFrame != on )
+	{
+		stopImages();
+
+		m_bestFrame = on;
+	}
+}
+
+qreal
+Frames::duplicateEpsilon() const
+{
+	return m_duplicateEpsilon;
+}
+
+void
+Frames::setDuplicateEpsilon( qreal v )
+{
+	m_duplicateEpsilon = v;
+}
+
+bool
+Frames::isIdle() const
+{
+	return m_idle;
+}
+
+void
+Frames::setIdleMode( int timeout, const Cfg::Resolution & r )
+{
+	m_idleTimeout = timeout;
+	m_idleResolution = r;
+
+	updateIdleFormat();
+
+	if( m_idle && ( m_idleTimeout <= 0 || m_idleFormat.isNull() ) )
+		switchFormat( m_format, false );
+	else if( m_idle && m_cam->cameraFormat() != m_idleFormat )
+		switchFormat( m_idleFormat, true );
+
+	restartIdleTimer();
+}
+
+void
+Frames::updateIdleFormat()
+{
+	m_idleFormat = QCameraFormat();
+
+	// Without configured format there is no format to get back to.
+	if( !m_cam || m_format.isNull() )
+		return;
+
+	const auto dev = m_cam->cameraDevice();
+
+	m_idleFormat = Devices::instance().format( dev, m_idleResolution );
+
+	if( m_idleFormat.isNull() )
+	{
+		// Keep pixel format, so conversion doesn't change on switch.
+		const auto cost = [] ( const QCameraFormat & f ) -> qreal
+		{
+			return (qreal) f.resolution().width() * f.resolution().height() *
+				f.maxFrameRate();
+		};
+
+		const auto formats = dev.videoFormats();
+
+		for( const auto & f : formats )
+		{
+			if( f.pixelFormat() == m_format.pixelFormat() &&
+				( m_idleFormat.isNull() || cost( f ) < cost( m_idleFormat ) ) )
+					m_idleFormat = f;
+		}
+	}
+
+	if( m_idleFormat == m_format )
+		m_idleFormat = QCameraFormat();
+}
+
+void
+Frames::restartIdleTimer()
+{
+	if( m_cam && m_idleTimeout > 0 && !m_idleFormat.isNull() &&
+		!m_idle && !m_detector.motion() )
+			m_idleTimer->start( m_idleTimeout * 1000 );
+	else
+		m_idleTimer->stop();
+}
+
+void
+Frames::enterIdle()
+{
+	if( m_cam && !m_idle && !m_idleFormat.isNull() && !m_detector.motion() )
+		switchFormat( m_idleFormat, true );
+}
+
+void
+Frames::switchFormat( const QCameraFormat & fmt, bool idle )
+{
+	m_idle = idle;
+	m_switching = true;
+
+	if( m_metrics )
+		m_metrics->m_idle = ( idle ? 1 : 0 );
+
+	m_cam->stop();
+	m_cam->setCameraFormat( fmt );
+
+	// Sharpness depends on resolution.
+	m_tamper.reset();
+
+	m_camStarted = Tracer::instance().now();
+
+	m_cam->start();
+}
+
 QCameraDevice
 Frames::cameraDevice() const
 {
@@ -147,96 +558,400 @@ Frames::cameraDevice() const
 		return QCameraDevice();
 }
 
+CameraMetrics *
+Frames::metrics() const
+{
+	return m_metrics;
+}
+
+bool
+Frames::isPreviewEnabled() const
+{
+	return m_previewEnabled;
+}
+
+void
+Frames::setPreviewEnabled( bool on )
+{
+	m_previewEnabled = on;
+}
+
+void
+Frames::setPreviewInterval( int ms )
+{
+	m_previewInterval = ms;
+}
+
+void
+Frames::setPreviewSize( const QSize & s )
+{
+	m_previewSize = s;
+}
+
+QSize
+Frames::analysisSize( const QSize & frame ) const
+{
+	if( m_detectionWidth > 0 && frame.width() > m_detectionWidth )
+		return frame.scaled( QSize( m_detectionWidth, frame.height() ),
+			Qt::KeepAspectRatio );
+	else
+		return frame;
+}
+
+QSize
+Frames::conversionSize( const QSize & frame, bool key, bool preview ) const
+{
+	QSize res;
+
+	if( key )
+	{
+		res = analysisSize( frame );
+
+		if( res == frame )
+			return QSize();
+	}
+
+	if( preview )
+	{
+		if( m_previewSize.isEmpty() )
+			return QSize();
+
+		// Preview is fitted after transformation.
+		QSize s = m_previewSize;
+		const qreal angle = std::fmod( qAbs( m_rotation ), 180.0 );
+
+		if( qAbs( angle - 90.0 ) < 0.01 )
+			s.transpose();
+		else if( angle > 0.01 )
+			s = QSize( qMax( s.width(), s.height() ), qMax( s.width(), s.height() ) );
+
+		res = res.expandedTo( frame.scaled( s, Qt::KeepAspectRatio ) );
+	}
+
+	if( res.width() < frame.width() && res.height() < frame.height() )
+		return res;
+	else
+		return QSize();
+}
+
 void
 Frames::frame( const QVideoFrame & frame )
 {
+	if( m_metrics )
+		++m_metrics->m_deliveredFrames;
+
+	const qint64 id = ++m_frameId;
+
+	if( m_camStarted >= 0 )
+	{
+		const qint64 duration = Tracer::instance().now() - m_camStarted;
+
+		if( Tracer::isEnabled() )
+			Tracer::instance().add( m_switching ? "switch" : "start", m_camStarted,
+				duration, id );
+
+		if( m_switching )
+		{
+			m_switching = false;
+
+			if( m_metrics )
+			{
+				m_metrics->m_switchTime.observe( duration / 1000 );
+				++m_metrics->m_formatSwitches;
+			}
+
+			emit formatSwitched( m_idle, duration / 1000 );
+
+			// Camera restarted, capture requested while switching.
+			if( m_capturePending )
+			{
+				m_capturePending = false;
+
+				takeImage( m_pendingDir );
+			}
+		}
+
+		m_camStarted = -1;
+		m_frameTime = -1;
+	}
+
+	if( m_outageStarted >= 0 )
+	{
+		const qint64 duration = Tracer::instance().now() - m_outageStarted;
+
+		if( Tracer::isEnabled() )
+			Tracer::instance().add( "outage", m_outageStarted, duration, id );
+
+		if( m_metrics )
+			m_metrics->m_outageMsecs += duration / 1000000;
+
+		m_outageStarted = -1;
+		m_reconnectTimer->stop();
+		m_reconnectDelay = c_minReconnectDelay;
+
+		emit reconnected( duration / 1000000 );
+
+		m_frameTime = -1;
+	}
+
+	// Sink keeps only the latest frame, frames of the camera arrived while
+	// this thread was busy are never delivered and show up as a gap in time.
+	const qint64 frameTime = frame.startTime();
+
+	if( frameTime >= 0 && m_frameTime >= 0 && m_metrics )
+	{
+		qreal fps = frame.surfaceFormat().frameRate();
+
+		if( fps <= 0.0 && m_cam )
+			fps = m_cam->cameraFormat().maxFrameRate();
+
+		if( fps > 0.0 )
+		{
+			const qint64 interval = qMax( Q_INT64_C( 1 ),
+				qRound64( 1000000.0 / fps ) );
+			const qint64 skipped = ( frameTime - m_frameTime + interval / 2 ) /
+				interval - 1;
+
+			if( skipped > 0 )
+				m_metrics->m_droppedFrames += skipped;
+		}
+	}
+
+	m_frameTime = frameTime;
+
 	QVideoFrame f = frame;
-	f.map( QVideoFrame::ReadOnly );
 
-	if( f.isValid() )
 	{
-		QImage image = f.toImage();
+		ScopedTrace trace( "map", id );
 
-		f.unmap();
+		f.map( QVideoFrame::ReadOnly );
+	}
 
+	if( f.isValid() )
+	{
 		if( m_counter == c_keyFrameChangesOn )
 			m_counter = 0;
 
-		QImage tmp = ( m_transformApplied ? image.transformed( m_transform )
-			:	image.copy() );
+		const bool key = ( m_counter == 0 );
+		const bool preview = m_previewEnabled && ( key || m_detector.motion() ) &&
+			( m_previewInterval <= 0 || !m_previewTimer.isValid() ||
+				m_previewTimer.elapsed() >= m_previewInterval );
+
+		// Candidates for the best frame are scored on luma of the mapped
+		// frame, only better ones are converted.
+		qreal frameScore = -1.0;
+
+		if( m_window )
+		{
+			ScopedTrace trace( "score", id );
+
+			frameScore = score( frameSharpness( f ) );
+		}
+
+		bool better = ( frameScore > m_bestScore );
 
-		if( m_counter == 0 )
+		if( key || preview || better )
 		{
-			if( !m_keyFrame.isNull() )
-				detectMotion( m_keyFrame, tmp );
+			QImage image;
+
+			{
+				ScopedTrace trace( "toImage", id );
+
+				// Frames that are not kept are scaled while converted,
+				// unscored ones need full size for the score.
+				const QSize size = ( !better && ( !m_window || frameScore >= 0.0 ) ?
+					conversionSize( f.size(), key, preview ) : QSize() );
+
+				image = ( size.isValid() ? frameToImage( f, size ) : frameToImage( f ) );
+			}
+
+			f.unmap();
+
+			// Luma of the format is not accessible, only converted frames
+			// are scored.
+			if( m_window && frameScore < 0.0 && !image.isNull() )
+			{
+				ScopedTrace trace( "score", id );
+
+				const QImage gray = image.convertToFormat( QImage::Format_Grayscale8 );
+
+				frameScore = score( sharpness( gray.constBits(), gray.width(),
+					gray.height(), gray.bytesPerLine(), 1 ) );
+				better = ( frameScore > m_bestScore );
+			}
+
+			// Camera delivers frames at capture resolution, detection runs
+			// on frames decimated once to the detection width. Size is of
+			// the frame, so it doesn't depend on size of conversion.
+			const QSize analysed = analysisSize( f.size() );
+			const bool decimate = ( key && !image.isNull() &&
+				image.size() != analysed );
+
+			QImage tmp;
+
+			if( preview || better || !decimate )
+			{
+				ScopedTrace trace( "transform", id );
+
+				tmp = transformed( image );
+			}
+
+			if( key )
+			{
+				QImage frameToDetect = tmp;
+
+				if( decimate )
+				{
+					ScopedTrace trace( "decimate", id );
 
-			m_keyFrame = tmp;
+					frameToDetect = transformed( scaleToSize( image, analysed ) );
+				}
 
-			emit newFrame( m_keyFrame );
+				{
+					ScopedTrace trace( "detect", id );
+
+					detectMotion( frameToDetect );
+				}
+			}
+
+			if( better )
+			{
+				m_best = tmp;
+				m_bestScore = frameScore;
+				m_bestTime = QDateTime::currentDateTime();
+				m_bestId = id;
+			}
+
+			if( preview )
+			{
+				ScopedTrace trace( "emit", id );
+
+				m_previewTimer.start();
+
+				emit newFrame( tmp );
+			}
 		}
-		else if( m_motion )
-			emit newFrame( tmp );
+		else
+			f.unmap();
 
 		++m_counter;
 		++m_fps;
 
 		m_timer->start();
 	}
+	else if( m_metrics )
+		++m_metrics->m_unmappedFrames;
 }
 
 void
-Frames::detectMotion( const QImage & key, const QImage & image )
+Frames::detectMotion( const QImage & image )
 {
+	const bool wasMotion = m_detector.motion();
+
 	bool detected = false;
-	
-	if( key.size() == image.size() )
+
+	QElapsedTimer timer;
+	timer.start();
+
 	{
-		double errorL2 = 0.0;
-		
-		// Calculate the L2 relative error between images.
-		for( int x = 0; x < key.width(); ++x )
+		QMutexLocker lock( &m_mutex );
+
+		detected = m_detector.process( image );
+	}
+
+	++m_analysedFps;
+
+	if( m_metrics )
+	{
+		m_metrics->m_detectTime.observe( timer.nsecsElapsed() / 1000 );
+		++m_metrics->m_analysedFrames;
+	}
+
+	if( m_detector.hasDifference() )
+	{
+		emit imgDiff( m_detector.difference() );
+
+		emit motionMap( m_detector.motionMap() );
+	}
+
+	const bool profiles = ( m_calibrating || m_rollingTimer->isActive() ||
+		m_dayThreshold > 0.0 || m_nightThreshold > 0.0 );
+
+	if( profiles || m_tamperDetection )
+	{
+		const qreal luma = m_detector.lumaMean();
+
+		if( profiles && m_detector.hasDifference() )
 		{
-			for( int y = 0; y < key.height(); ++y )
+			// Jumps of lighting are not noise of the scene. Rolling
+			// calibration takes only quiet frames, even when hysteresis
+			// didn't start motion on them.
+			if( !m_detector.lightingChanged() && ( m_calibrating ||
+				( m_rollingTimer->isActive() && !wasMotion && !detected &&
+					!m_detector.isActive() ) ) )
+						m_calibration.add( m_detector.difference(), luma );
+
+			const auto profile = m_calibration.updateProfile( luma );
+
+			if( profile != m_profile )
 			{
-				const auto p1 = key.pixelColor( x, y );
-				const auto p2 = image.pixelColor( x, y );
-				
-				const auto r = p1.redF() - p2.redF();
-				const auto r2 = r * r;
-				
-				const auto g = p1.greenF() - p2.greenF();
-				const auto g2 = g * g;
-				
-				const auto b = p1.blueF() - p2.blueF();
-				const auto b2 = b * b;
-				
-				errorL2 += std::sqrt( r2 + g2 + b2 );
+				QMutexLocker lock( &m_mutex );
+
+				m_profile = profile;
+
+				applyThreshold();
 			}
 		}
-		
-		// Convert to a reasonable scale, since L2 error is summed across
-		// all pixels of the image.
-		const double similarity = errorL2 / (double)( key.width() * key.height() );
-	
-		detected = similarity > m_threshold;
-	
-		emit imgDiff( similarity );
+
+		// Statistics of the frame are taken by the detector.
+		if( m_tamperDetection && m_tamper.update( luma, m_detector.lumaDeviation(),
+			m_detector.lumaSharpness(), QDateTime::currentMSecsSinceEpoch() ) )
+		{
+			if( m_metrics )
+				++m_metrics->m_tamperEvents;
+
+			emit tamperDetected( m_tamper.reasons() );
+		}
 	}
 
-	if( m_motion && !detected )
+	if( m_detector.lightingChanged() )
 	{
-		m_motion = false;
+		if( m_metrics )
+			++m_metrics->m_lightingChanges;
+
+		emit lightingChanged();
+	}
+
+	if( wasMotion && !detected )
+	{
+		restartIdleTimer();
 
 		emit noMoreMotions();
 	}
-	else if( !m_motion && detected )
+	else if( !wasMotion && detected )
 	{
-		m_motion = true;
+		if( m_metrics )
+			++m_metrics->m_motionEvents;
+
+		m_idleTimer->stop();
+
+		if( m_idle )
+			switchFormat( m_format, false );
 
 		emit motionDetected();
 	}
 }
 
+qreal
+Frames::score( qreal sharpness ) const
+{
+	if( sharpness < 0.0 )
+		return -1.0;
+
+	// Sharp frames with the most of motion are the best.
+	return sharpness * ( 1.0 + m_detector.motionMap().coverage() );
+}
+
 void
 Frames::noFramesTimeout()
 {
@@ -244,9 +959,51 @@ Frames::noFramesTimeout()
 
 	m_timer->stop();
 
+	if( m_outageStarted < 0 )
+	{
+		// Outage started with the last frame.
+		m_outageStarted = Tracer::instance().now() -
+			(qint64) c_noFramesTimeout * 1000000;
+		m_reconnectDelay = c_minReconnectDelay;
+
+		if( m_metrics )
+			++m_metrics->m_outages;
+
+		m_reconnectTimer->start( m_reconnectDelay );
+	}
+
 	emit noFrames();
 }
 
+void
+Frames::reconnect()
+{
+	// Wait longer every time, so dead camera doesn't eat CPU.
+	m_reconnectDelay = qMin( m_reconnectDelay * 2, c_maxReconnectDelay );
+	m_reconnectTimer->start( m_reconnectDelay );
+
+	if( m_camName.isEmpty() )
+		return;
+
+	// Wait for this camera to be back on the bus.
+	if( Devices::instance().camera( m_camName ).isNull() )
+		return;
+
+	Cfg::Resolution r = m_resolution;
+
+	if( !m_format.isNull() )
+	{
+		r.set_width( m_format.resolution().width() );
+		r.set_height( m_format.resolution().height() );
+		r.set_fps( m_format.maxFrameRate() );
+		r.set_format( pixelFormatToString( m_format.pixelFormat() ) );
+	}
+
+	ScopedTrace trace( "reconnect" );
+
+	initCam( m_camName, r );
+}
+
 void
 Frames::second()
 {
@@ -254,27 +1011,36 @@ Frames::second()
 
 	emit fps( m_fps );
 
+	if( m_metrics )
+	{
+		m_metrics->m_deliveredFps = m_fps;
+		m_metrics->m_analysedFps = m_analysedFps;
+	}
+
 	m_fps = 0;
+	m_analysedFps = 0;
 }
 
 void
 Frames::initCam( const QString & name )
 {
-	const auto cameras = QMediaDevices::videoInputs();
+	initCam( name, Cfg::Resolution() );
+}
 
-	if( !cameras.isEmpty() )
-	{
-		QCameraDevice dev = cameras.at( 0 );
+void
+Frames::initCam( const QString & name, const Cfg::Resolution & r )
+{
+	m_camName = name;
+	m_resolution = r;
+	m_metrics = Metrics::instance().camera( name );
 
-		for( const auto & cameraInfo : cameras )
-		{
-			if( cameraInfo.description() == name )
-			{
-				dev = cameraInfo;
-				break;
-			}
-		}
+	// Watchdog reconnects camera that delivers no frames or is missing.
+	m_timer->start();
+
+	const QCameraDevice dev = Devices::instance().camera( name );
 
+	if( !dev.isNull() )
+	{
 		if( m_cam )
 			m_cam->deleteLater();
 
@@ -289,12 +1055,30 @@ Frames::initCam( const QString & name )
 				this, &Frames::imageCaptured );
 		}
 
+		const QCameraFormat fmt = Devices::instance().format( dev, r );
+
+		if( !fmt.isNull() )
+			m_cam->setCameraFormat( fmt );
+
+		m_format = fmt;
+		m_idle = false;
+		m_switching = false;
+		m_capturePending = false;
+
+		m_metrics->m_idle = 0;
+
+		updateIdleFormat();
+
 		m_cam->setFocusMode( QCamera::FocusModeAuto );
 		m_capture.setCamera( m_cam );
 		m_capture.setVideoSink( this );
 		m_capture.setImageCapture( m_imgCapture );
 
+		m_camStarted = Tracer::instance().now();
+
 		m_cam->start();
+
+		restartIdleTimer();
 	}
 }
 
@@ -303,13 +1087,91 @@ Frames::imageCaptured( int id, const QImage & img )
 {
 	const auto fileName = m_fileNames[ id ];
 	m_fileNames.remove( id );
+	const qint64 started = m_captureStarted.take( id );
+
+	if( Tracer::isEnabled() )
+		Tracer::instance().add( "capture", started,
+			Tracer::instance().now() - started, id );
+
 	const auto toSave = ( m_transformApplied ? img.transformed( m_transform ) : img );
-	toSave.save( fileName );
+
+	writeImage( id, toSave, fileName );
+
+	if( m_metrics )
+		m_metrics->m_captureQueue = m_fileNames.size();
+}
+
+void
+Frames::writeImage( qint64 id, const QImage & toSave, const QString & fileName )
+{
+	if( m_duplicateEpsilon > 0.0 )
+	{
+		ScopedTrace trace( "dedup", id );
+
+		const QByteArray print = fingerprint( toSave );
+
+		if( fingerprintDifference( print, m_lastSaved ) < m_duplicateEpsilon )
+		{
+			if( m_metrics )
+				++m_metrics->m_imagesSuppressed;
+
+			return;
+		}
+
+		m_lastSaved = print;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	QByteArray data;
+
+	{
+		ScopedTrace trace( "encode", id );
+
+		QBuffer buffer( &data );
+		buffer.open( QIODevice::WriteOnly );
+		toSave.save( &buffer, "JPG" );
+		buffer.close();
+	}
+
+	const qint64 encoded = timer.nsecsElapsed() / 1000;
+
+	timer.restart();
+
+	ScopedTrace trace( "write", id );
+
+	QFile file( fileName );
+
+	if( file.open( QIODevice::WriteOnly ) )
+	{
+		file.write( data );
+		file.close();
+
+		if( m_metrics )
+		{
+			m_metrics->m_encodeTime.observe( encoded );
+			m_metrics->m_writeTime.observe( timer.nsecsElapsed() / 1000 );
+			++m_metrics->m_imagesWritten;
+			m_metrics->m_bytesWritten += data.size();
+		}
+	}
 }
 
 void
 Frames::stopCam()
 {
+	stopImages();
+
+	m_idleTimer->stop();
+	m_timer->stop();
+	m_reconnectTimer->stop();
+	m_outageStarted = -1;
+
+	m_idle = false;
+	m_switching = false;
+	m_capturePending = false;
+
 	if( m_cam )
 	{
 		m_cam->stop();
@@ -328,30 +1190,103 @@ Frames::setResolution( const QCameraFormat & fmt )
 {
 	if( m_cam )
 	{
-		m_cam->stop();
-		m_cam->setCameraFormat( fmt );
-		m_cam->start();
+		m_format = fmt;
+
+		updateIdleFormat();
+
+		if( m_cam->cameraFormat() != fmt )
+		{
+			m_idle = false;
+
+			if( m_metrics )
+				m_metrics->m_idle = 0;
+
+			m_cam->stop();
+			m_cam->setCameraFormat( fmt );
+
+			m_camStarted = Tracer::instance().now();
+
+			m_cam->start();
+		}
+
+		restartIdleTimer();
 	}
 }
 
-void
-Frames::takeImage( const QString & dirName )
+//! \return File name of the image taken at the given time, directory is created.
+static QString
+imageFileName( const QString & dirName, const QDateTime & time )
 {
-	const QDateTime current = QDateTime::currentDateTime();
-
 	QDir dir( dirName );
 
 	const QString path = dir.absolutePath() +
-		current.date().toString( QLatin1String( "/yyyy/MM/dd/" ) );
+		time.date().toString( QLatin1String( "/yyyy/MM/dd/" ) );
 
 	dir.mkpath( path );
 
-	const auto fileName = path +
-		current.toString( QStringLiteral( "hh.mm.ss" ) ) + QStringLiteral( ".jpg" );
+	return path +
+		time.toString( QStringLiteral( "hh.mm.ss" ) ) + QStringLiteral( ".jpg" );
+}
+
+void
+Frames::saveBestFrame()
+{
+	if( !m_best.isNull() )
+		writeImage( m_bestId, m_best, imageFileName( m_windowDir, m_bestTime ) );
+
+	m_best = QImage();
+	m_bestScore = -1.0;
+	m_bestId = -1;
+}
+
+void
+Frames::stopImages()
+{
+	if( m_window )
+	{
+		saveBestFrame();
+
+		m_window = false;
+	}
+}
+
+void
+Frames::takeImage( const QString & dirName )
+{
+	if( m_bestFrame )
+	{
+		saveBestFrame();
+
+		m_window = true;
+		m_windowDir = dirName;
+
+		return;
+	}
+
+	// Camera is restarted on switch of format and can't capture.
+	if( m_switching )
+	{
+		m_capturePending = true;
+		m_pendingDir = dirName;
+
+		return;
+	}
+
+	const auto fileName = imageFileName( dirName, QDateTime::currentDateTime() );
+
+	const qint64 started = Tracer::instance().now();
 
 	const auto id = m_imgCapture->capture();
 
+	// Capture failed, error is reported by QImageCapture.
+	if( id < 0 )
+		return;
+
 	m_fileNames.insert( id, fileName );
+	m_captureStarted.insert( id, started );
+
+	if( m_metrics )
+		m_metrics->m_captureQueue = m_fileNames.size();
 }
 
 } /* namespace Stock */
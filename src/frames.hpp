@@ -13,9 +13,14 @@
 #include <QMediaCaptureSession>
 #include <QMutex>
 #include <QMap>
+#include <QElapsedTimer>
+#include <QDateTime>
 
 // SecurityCam include.
 #include "cfg.hpp"
+#include "detector.hpp"
+#include "metrics.hpp"
+#include "calibration.hpp"
 
 
 namespace SecurityCam {
@@ -43,10 +48,22 @@ signals:
 	void noMoreMotions();
 	//! Images difference.
 	void imgDiff( qreal diff );
+	//! Map of motion updated.
+	void motionMap( const SecurityCam::MotionMap & map );
+	//! Lighting of the scene changed, reference is updated without motion.
+	void lightingChanged();
+	//! Camera is tampered, reasons are combination of Tamper::Reason.
+	void tamperDetected( int reasons );
+	//! Threshold calibrated, -1 for profile without enough samples.
+	void calibrated( qreal day, qreal night );
 	//! No frames.
 	void noFrames();
+	//! Camera delivers frames again after outage of the given milliseconds.
+	void reconnected( qint64 msecs );
 	//! FPS.
 	void fps( int v );
+	//! Format switched to idle or full one, time to the first frame in microseconds.
+	void formatSwitched( bool idle, qint64 usecs );
 
 public:
 	explicit Frames( const Cfg::Cfg & cfg, QObject * parent = nullptr );
@@ -69,38 +86,135 @@ public:
 	//! Set threshold.
 	void setThreshold( qreal v );
 
+	//! Set thresholds of day and night, 0 means threshold.
+	void setProfileThresholds( qreal day, qreal night );
+	//! Set rules of calibration, see Calibration::setRules().
+	void setCalibrationRules( qreal percentile, qreal margin, qreal nightLuma );
+	//! \return Is calibration in progress.
+	bool isCalibrating() const;
+
 	//! Apply new transformations.
 	void applyTransform( bool on = true );
 
-	//! \return Current format of the camera.
+	//! Set rules of blobs, see Detector::setBlobRules().
+	void setBlobRules( qreal pixelThreshold, qreal minArea, int minCount );
+	//! Set compensation of lighting, see Detector::setLightCompensation().
+	void setLightCompensation( bool on, qreal lightingThreshold );
+	//! Enable or disable detection of tamper, see Tamper::setRules().
+	void setTamperDetection( bool on, qreal minDeviation, qreal sharpnessDrop,
+		qreal lumaChange, int duration );
+	//! Set threshold of end of motion and N-of-M confirmation of start and
+	//! end of motion with minimum duration in milliseconds.
+	void setHysteresis( qreal offThreshold, int confirmations, int window,
+		int minDuration );
+
+	//! \return Width of frames for detection, 0 means full resolution.
+	int detectionWidth() const;
+	//! Set width of frames for detection, 0 means full resolution.
+	void setDetectionWidth( int w );
+
+	//! \return Copy of the detector with current settings and without state.
+	Detector detector() const;
+
+	//! \return Configured format of the camera, idle format is not reported.
 	QCameraFormat cameraFormat() const;
 
+	//! \return Is camera in idle format.
+	bool isIdle() const;
+
+	//! \return Is only the best frame of the snapshot interval saved.
+	bool isBestFrame() const;
+	//! Save only the best frame of the snapshot interval instead of taking
+	//! image on every call of takeImage().
+	void setBestFrame( bool on );
+
+	//! \return Difference with the last saved image below which image is not saved.
+	qreal duplicateEpsilon() const;
+	//! Set difference with the last saved image below which image is not
+	//! saved, 0 saves all images.
+	void setDuplicateEpsilon( qreal v );
+
 	//! \return Current camera device.
 	QCameraDevice cameraDevice() const;
 
+	//! \return Metrics of the current camera.
+	CameraMetrics * metrics() const;
+
+	//! \return Is preview enabled.
+	bool isPreviewEnabled() const;
+
 public slots:
 	//! Init camera.
 	void initCam( const QString & name );
+	//! Init camera with the configured resolution. Camera is started once,
+	//! with the right format.
+	void initCam( const QString & name, const SecurityCam::Cfg::Resolution & r );
 	//! Stop camera.
 	void stopCam();
 	//! Set resolution.
 	void setResolution( const QCameraFormat & fmt );
-	//! Take image.
+	//! Take image. With best frame policy saves the best frame since the
+	//! previous call and starts new window.
 	void takeImage( const QString & dirName );
+	//! Stop taking images, the best frame of the current window is saved.
+	void stopImages();
+	//! Enable or disable emitting of new frames for preview.
+	void setPreviewEnabled( bool on );
+	//! Set minimum interval in milliseconds between frames for preview.
+	void setPreviewInterval( int ms );
+	//! Set size of preview in device pixels, frames only for preview are
+	//! converted at this size.
+	void setPreviewSize( const QSize & s );
+	//! Start calibration of threshold on quiet scene for the given seconds.
+	void startCalibration( int secs );
+	//! Recalibrate threshold every given minutes on frames without motion,
+	//! 0 disables.
+	void setRollingCalibration( int minutes );
+	//! Set idle mode. After timeout seconds without motion camera is switched
+	//! to the idle format, 0 disables idle mode. Null resolution means the
+	//! cheapest format with the same pixel format.
+	void setIdleMode( int timeout, const SecurityCam::Cfg::Resolution & r );
 
 private slots:
 	//! Video frame changed.
 	void frame( const QVideoFrame & frame );
 	//! No frames timeout.
 	void noFramesTimeout();
+	//! Try to reconnect the camera.
+	void reconnect();
 	//! 1 second.
 	void second();
 	//! Image captured.
 	void imageCaptured( int id, const QImage & img );
+	//! Quiet period elapsed.
+	void enterIdle();
+	//! Finish calibration and apply thresholds.
+	void finishCalibration();
 
 private:
 	//! Detect motion.
-	void detectMotion( const QImage & key, const QImage & image );
+	void detectMotion( const QImage & image );
+	//! \return Transformed image.
+	QImage transformed( const QImage & image ) const;
+	//! \return Size of analysed frames for frame of the given size.
+	QSize analysisSize( const QSize & frame ) const;
+	//! \return Size to convert frame of the given size to, invalid size if
+	//! it should be converted at full size.
+	QSize conversionSize( const QSize & frame, bool key, bool preview ) const;
+	//! Restart camera with the given format.
+	void switchFormat( const QCameraFormat & fmt, bool idle );
+	//! Find idle format.
+	void updateIdleFormat();
+	//! Restart timer of quiet period.
+	void restartIdleTimer();
+	//! Set threshold of the current profile to the detector, mutex should be locked.
+	void applyThreshold();
+	//! \return Score of the frame with the given sharpness.
+	qreal score( qreal sharpness ) const;
+	//! Save the best frame of the window.
+	void saveBestFrame();
+	//! Encode and write image.
+	void writeImage( qint64 id, const QImage & img, const QString & fileName );
 
 private:
 	Q_DISABLE_COPY( Frames )
@@ -109,38 +223,118 @@ private:
 	QCamera * m_cam;
 	//! Counter.
 	int m_counter;
-	//! Key frame counter.
-	int m_keyFrameCounter;
-	//! Current frame.
-	QImage m_currentFrame;
-	//! Key frame.
-	QImage m_keyFrame;
 	//! Transform.
 	QTransform m_transform;
 	//! Capture.
 	QMediaCaptureSession m_capture;
-	//! Motions was detected.
-	bool m_motion;
 	//! Mutex.
 	mutable QMutex m_mutex;
 	//! Transformation applied.
 	bool m_transformApplied;
+	//! Motion detector.
+	Detector m_detector;
 	//! Threshold.
 	qreal m_threshold;
+	//! Threshold of day.
+	qreal m_dayThreshold;
+	//! Threshold of night.
+	qreal m_nightThreshold;
+	//! Detector of tamper.
+	Tamper m_tamper;
+	//! Is detection of tamper enabled.
+	bool m_tamperDetection;
+	//! Calibration.
+	Calibration m_calibration;
+	//! Current profile.
+	Calibration::Profile m_profile;
+	//! Is calibration in progress.
+	bool m_calibrating;
+	//! Calibration timer.
+	QTimer * m_calibrationTimer;
+	//! Rolling calibration timer.
+	QTimer * m_rollingTimer;
 	//! Rotation.
 	qreal m_rotation;
 	//! Mirrored.
 	bool m_mirrored;
+	//! Width of frames for detection.
+	int m_detectionWidth;
 	//! Timer.
 	QTimer * m_timer;
 	//! 1 second timer.
 	QTimer * m_secTimer;
 	//! FPS.
 	int m_fps;
+	//! Analysed FPS.
+	int m_analysedFps;
+	//! Metrics.
+	CameraMetrics * m_metrics;
+	//! Name of the camera.
+	QString m_camName;
+	//! Requested resolution of the camera.
+	Cfg::Resolution m_resolution;
+	//! Id of the last frame.
+	qint64 m_frameId;
+	//! Start time of the last frame in microseconds, -1 if unknown.
+	qint64 m_frameTime;
+	//! Is preview enabled.
+	bool m_previewEnabled;
+	//! Minimum interval between frames for preview.
+	int m_previewInterval;
+	//! Size of preview.
+	QSize m_previewSize;
+	//! Time since last frame for preview.
+	QElapsedTimer m_previewTimer;
 	//! Image capture.
 	QImageCapture * m_imgCapture;
 	//! Map of file names.
 	QMap< int, QString > m_fileNames;
+	//! Map of capture start times.
+	QMap< int, qint64 > m_captureStarted;
+	//! Time when camera was started, -1 if first frame arrived.
+	qint64 m_camStarted;
+	//! Reconnect timer.
+	QTimer * m_reconnectTimer;
+	//! Delay of the next reconnect, in milliseconds.
+	int m_reconnectDelay;
+	//! Time when outage started, -1 if there is no outage.
+	qint64 m_outageStarted;
+	//! Configured format.
+	QCameraFormat m_format;
+	//! Idle format.
+	QCameraFormat m_idleFormat;
+	//! Configured idle resolution.
+	Cfg::Resolution m_idleResolution;
+	//! Quiet period before idle, in seconds.
+	int m_idleTimeout;
+	//! Idle timer.
+	QTimer * m_idleTimer;
+	//! Is camera in idle format.
+	bool m_idle;
+	//! Is switch of format in progress.
+	bool m_switching;
+	//! Is capture deferred till the end of switch of format.
+	bool m_capturePending;
+	//! Directory of the deferred capture.
+	QString m_pendingDir;
+	//! Is only the best frame saved.
+	bool m_bestFrame;
+	//! Is window of the best frame open.
+	bool m_window;
+	//! Directory of images of the window.
+	QString m_windowDir;
+	//! The best frame of the window.
+	QImage m_best;
+	//! Score of the best frame.
+	qreal m_bestScore;
+	//! Time of the best frame.
+	QDateTime m_bestTime;
+	//! Id of the best frame.
+	qint64 m_bestId;
+	//! Epsilon of near duplicates.
+	qreal m_duplicateEpsilon;
+	//! Fingerprint of the last saved image.
+	QByteArray m_lastSaved;
 }; // class Frames
 
 } /* namespace SecurityCam */
@@ -0,0 +1,344 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include "gridview.hpp"
+#include "view.hpp"
+#include "preview.hpp"
+#include "metrics.hpp"
+
+// Qt include.
+#include <QGridLayout>
+#include <QVector>
+#include <QMouseEvent>
+
+// C++ include.
+#include <cmath>
+
+
+namespace SecurityCam {
+
+//! Maximum FPS of the tile that occupies whole grid.
+static const int c_maxFps = 30;
+
+//! Maximum interval between frames of not focused tile.
+static const int c_maxInterval = 1000;
+
+
+//
+// Tile
+//
+
+//! Tile of the grid.
+struct Tile {
+	//! Camera.
+	QString m_camera;
+	//! View.
+	View * m_view;
+	//! Preview.
+	Preview * m_preview;
+	//! Size.
+	QSize m_size;
+	//! Size in device pixels, frames are converted and scaled to it.
+	QSize m_deviceSize;
+}; // struct Tile
+
+
+//
+// GridViewPrivate
+//
+
+class GridViewPrivate {
+public:
+	explicit GridViewPrivate( GridView * parent )
+		:	m_layout( nullptr )
+		,	m_maximized( false )
+		,	m_overlayEnabled( false )
+		,	q( parent )
+	{
+	}
+
+	//! Init.
+	void init();
+	//! Place tiles.
+	void relayout();
+	//! Recalculate frame intervals of tiles.
+	void updateRates();
+	//! \return Index of the camera's tile.
+	int indexOf( const QString & camera ) const;
+	//! \return Index of the tile with the given view.
+	int indexOf( const QObject * view ) const;
+
+	//! Tiles.
+	QVector< Tile > m_tiles;
+	//! Layout.
+	QGridLayout * m_layout;
+	//! Focused camera.
+	QString m_focused;
+	//! Show only focused camera.
+	bool m_maximized;
+	//! Overlay enabled.
+	bool m_overlayEnabled;
+	//! Parent.
+	GridView * q;
+}; // class GridViewPrivate
+
+void
+GridViewPrivate::init()
+{
+	m_layout = new QGridLayout( q );
+	m_layout->setContentsMargins( 0, 0, 0, 0 );
+	m_layout->setSpacing( 1 );
+}
+
+void
+GridViewPrivate::relayout()
+{
+	for( const auto & t : qAsConst( m_tiles ) )
+		m_layout->removeWidget( t.m_view );
+
+	const bool maximized = ( m_maximized && indexOf( m_focused ) >= 0 );
+	const int count = ( maximized ? 1 : m_tiles.size() );
+	const int columns = qMax( 1, (int) std::ceil( std::sqrt( (double) count ) ) );
+
+	int i = 0;
+
+	for( const auto & t : qAsConst( m_tiles ) )
+	{
+		t.m_view->setHighlighted( m_tiles.size() > 1 && t.m_camera == m_focused );
+
+		if( maximized && t.m_camera != m_focused )
+		{
+			t.m_view->hide();
+
+			continue;
+		}
+
+		m_layout->addWidget( t.m_view, i / columns, i % columns );
+		t.m_view->show();
+
+		++i;
+	}
+
+	updateRates();
+}
+
+void
+GridViewPrivate::updateRates()
+{
+	const double area = qMax( 1, q->width() * q->height() );
+
+	for( const auto & t : qAsConst( m_tiles ) )
+	{
+		int interval = 0;
+
+		if( !t.m_size.isEmpty() && m_tiles.size() > 1 && t.m_camera != m_focused )
+		{
+			const double fraction = (double) ( t.m_size.width() * t.m_size.height() ) / area;
+
+			interval = qMin( c_maxInterval,
+				qRound( 1000.0 / c_maxFps / qMax( fraction, 0.001 ) ) );
+		}
+
+		emit q->tileChanged( t.m_camera, t.m_deviceSize, interval );
+	}
+}
+
+int
+GridViewPrivate::indexOf( const QString & camera ) const
+{
+	for( int i = 0; i < m_tiles.size(); ++i )
+	{
+		if( m_tiles.at( i ).m_camera == camera )
+			return i;
+	}
+
+	return -1;
+}
+
+int
+GridViewPrivate::indexOf( const QObject * view ) const
+{
+	for( int i = 0; i < m_tiles.size(); ++i )
+	{
+		if( m_tiles.at( i ).m_view == view )
+			return i;
+	}
+
+	return -1;
+}
+
+
+//
+// GridView
+//
+
+GridView::GridView( QWidget * parent )
+	:	QWidget( parent )
+	,	d( new GridViewPrivate( this ) )
+{
+	d->init();
+}
+
+GridView::~GridView() noexcept
+{
+}
+
+void
+GridView::addCamera( const QString & camera )
+{
+	if( d->indexOf( camera ) >= 0 )
+		return;
+
+	Tile t;
+	t.m_camera = camera;
+	t.m_view = new View( this );
+	t.m_preview = new Preview( this );
+	t.m_preview->setMetrics( Metrics::instance().camera( camera ) );
+
+	t.m_view->installEventFilter( this );
+	t.m_view->setOverlayEnabled( d->m_overlayEnabled );
+
+	connect( t.m_view, &View::previewSizeChanged,
+		this, &GridView::viewSizeChanged );
+	connect( t.m_preview, &Preview::ready,
+		t.m_view, &View::draw, Qt::QueuedConnection );
+
+	d->m_tiles.append( t );
+
+	if( d->m_focused.isEmpty() )
+		d->m_focused = camera;
+
+	d->relayout();
+}
+
+void
+GridView::removeCamera( const QString & camera )
+{
+	const int i = d->indexOf( camera );
+
+	if( i < 0 )
+		return;
+
+	const Tile t = d->m_tiles.takeAt( i );
+
+	d->m_layout->removeWidget( t.m_view );
+
+	delete t.m_preview;
+	delete t.m_view;
+
+	if( d->m_focused == camera )
+		d->m_focused = ( d->m_tiles.isEmpty() ? QString() :
+			d->m_tiles.first().m_camera );
+
+	d->relayout();
+}
+
+QStringList
+GridView::cameras() const
+{
+	QStringList res;
+
+	for( const auto & t : qAsConst( d->m_tiles ) )
+		res.append( t.m_camera );
+
+	return res;
+}
+
+Preview *
+GridView::preview( const QString & camera ) const
+{
+	const int i = d->indexOf( camera );
+
+	return ( i >= 0 ? d->m_tiles.at( i ).m_preview : nullptr );
+}
+
+QString
+GridView::focusedCamera() const
+{
+	return d->m_focused;
+}
+
+void
+GridView::setFocusedCamera( const QString & camera )
+{
+	if( d->m_focused != camera && d->indexOf( camera ) >= 0 )
+	{
+		d->m_focused = camera;
+
+		d->relayout();
+	}
+}
+
+void
+GridView::setMaximized( bool on )
+{
+	if( d->m_maximized != on )
+	{
+		d->m_maximized = on;
+
+		d->relayout();
+	}
+}
+
+void
+GridView::setOverlayEnabled( bool on )
+{
+	d->m_overlayEnabled = on;
+
+	for( const auto & t : qAsConst( d->m_tiles ) )
+		t.m_view->setOverlayEnabled( on );
+}
+
+void
+GridView::setMotionMap( const QString & camera, const MotionMap & map )
+{
+	const int i = d->indexOf( camera );
+
+	if( i >= 0 )
+		d->m_tiles.at( i ).m_view->setMotionMap( map );
+}
+
+bool
+GridView::eventFilter( QObject * watched, QEvent * e )
+{
+	const int i = d->indexOf( watched );
+
+	if( i >= 0 )
+	{
+		if( e->type() == QEvent::MouseButtonPress )
+			setFocusedCamera( d->m_tiles.at( i ).m_camera );
+		else if( e->type() == QEvent::MouseButtonDblClick )
+		{
+			setFocusedCamera( d->m_tiles.at( i ).m_camera );
+			setMaximized( !d->m_maximized );
+		}
+	}
+
+	return QWidget::eventFilter( watched, e );
+}
+
+void
+GridView::viewSizeChanged( const QSize & s )
+{
+	const int i = d->indexOf( sender() );
+
+	if( i >= 0 )
+	{
+		Tile & t = d->m_tiles[ i ];
+
+		// Frames and preview use the same size in device pixels.
+		const qreal ratio = t.m_view->devicePixelRatioF();
+
+		t.m_size = s;
+		t.m_deviceSize = s * ratio;
+		t.m_preview->setSize( t.m_deviceSize, ratio );
+
+		d->updateRates();
+	}
+}
+
+} /* namespace SecurityCam */
@@ -0,0 +1,87 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef SECURITYCAM_GRIDVIEW_HPP_INCLUDED
+#define SECURITYCAM_GRIDVIEW_HPP_INCLUDED
+
+// Qt include.
+#include <QWidget>
+#include <QScopedPointer>
+
+// SecurityCam include.
+#include "detector.hpp"
+
+
+namespace SecurityCam {
+
+class Preview;
+
+
+//
+// GridView
+//
+
+class GridViewPrivate;
+
+//! Mosaic of views of cameras. Every tile gets frames downscaled to its
+//! size and throttled in proportion to its area, only focused tile gets
+//! all frames.
+class GridView final
+	:	public QWidget
+{
+	Q_OBJECT
+
+signals:
+	//! Tile of the camera changed. Size is in device pixels, empty size
+	//! means tile is not visible, interval is a minimum time in milliseconds
+	//! between frames of the tile.
+	void tileChanged( const QString & camera, const QSize & size, int interval );
+
+public:
+	explicit GridView( QWidget * parent );
+	~GridView() noexcept override;
+
+	//! Add camera.
+	void addCamera( const QString & camera );
+	//! Remove camera.
+	void removeCamera( const QString & camera );
+	//! \return Cameras.
+	QStringList cameras() const;
+
+	//! \return Preview of the camera, frames should be passed to it.
+	Preview * preview( const QString & camera ) const;
+
+	//! \return Focused camera.
+	QString focusedCamera() const;
+
+public slots:
+	//! Set focused camera.
+	void setFocusedCamera( const QString & camera );
+	//! Show only focused camera or all cameras.
+	void setMaximized( bool on );
+	//! Enable or disable overlay with motion.
+	void setOverlayEnabled( bool on );
+	//! Set map of motion of the camera.
+	void setMotionMap( const QString & camera, const SecurityCam::MotionMap & map );
+
+protected:
+	bool eventFilter( QObject * watched, QEvent * e ) override;
+
+private slots:
+	//! Size of the tile changed.
+	void viewSizeChanged( const QSize & s );
+
+private:
+	friend class GridViewPrivate;
+
+	Q_DISABLE_COPY( GridView )
+
+	QScopedPointer< GridViewPrivate > d;
+}; // class GridView
+
+} /* namespace SecurityCam */
+
+#endif // SECURITYCAM_GRIDVIEW_HPP_INCLUDED
@@ -0,0 +1,140 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include "integral.hpp"
+
+
+namespace SecurityCam {
+
+//
+// IntegralImage
+//
+
+IntegralImage::IntegralImage()
+	:	m_width( 0 )
+	,	m_height( 0 )
+{
+}
+
+bool
+IntegralImage::isEmpty() const
+{
+	return ( m_width == 0 || m_height == 0 );
+}
+
+int
+IntegralImage::width() const
+{
+	return m_width;
+}
+
+int
+IntegralImage::height() const
+{
+	return m_height;
+}
+
+void
+IntegralImage::resize( int width, int height )
+{
+	width = qMax( 0, width );
+	height = qMax( 0, height );
+
+	// First row and column are never written, table of the same size is reused.
+	if( width != m_width || height != m_height )
+	{
+		m_width = width;
+		m_height = height;
+
+		m_table.assign( ( m_width + 1 ) * ( m_height + 1 ), 0.0 );
+	}
+}
+
+void
+IntegralImage::accumulate( int y )
+{
+	// Independent per column, compiler vectorises it.
+	const double * prev = m_table.data() + y * ( m_width + 1 );
+	double * line = m_table.data() + ( y + 1 ) * ( m_width + 1 );
+
+	for( int x = 1; x <= m_width; ++x )
+		line[ x ] += prev[ x ];
+}
+
+void
+IntegralImage::build( const float * data, int width, int height, int stride )
+{
+	resize( width, height );
+
+	for( int y = 0; y < m_height; ++y )
+	{
+		const float * src = data + y * stride;
+		double * line = m_table.data() + ( y + 1 ) * ( m_width + 1 );
+		double rowSum = 0.0;
+
+		for( int x = 0; x < m_width; ++x )
+		{
+			rowSum += src[ x ];
+			line[ x + 1 ] = rowSum;
+		}
+
+		accumulate( y );
+	}
+}
+
+void
+IntegralImage::build( const uchar * data, int width, int height, int bytesPerLine,
+	int pixelStride )
+{
+	resize( width, height );
+
+	for( int y = 0; y < m_height; ++y )
+	{
+		const uchar * src = data + y * bytesPerLine;
+		double * line = m_table.data() + ( y + 1 ) * ( m_width + 1 );
+		double rowSum = 0.0;
+
+		for( int x = 0; x < m_width; ++x )
+		{
+			rowSum += src[ x * pixelStride ];
+			line[ x + 1 ] = rowSum;
+		}
+
+		accumulate( y );
+	}
+}
+
+double
+IntegralImage::sum( const QRect & r ) const
+{
+	const QRect c = r & QRect( 0, 0, m_width, m_height );
+
+	if( c.isEmpty() )
+		return 0.0;
+
+	const int w = m_width + 1;
+	const int x1 = c.x();
+	const int y1 = c.y();
+	const int x2 = c.x() + c.width();
+	const int y2 = c.y() + c.height();
+
+	return m_table[ y2 * w + x2 ] - m_table[ y1 * w + x2 ] -
+		m_table[ y2 * w + x1 ] + m_table[ y1 * w + x1 ];
+}
+
+double
+IntegralImage::mean( const QRect & r ) const
+{
+	const QRect c = r & QRect( 0, 0, m_width, m_height );
+
+	if( c.isEmpty() )
+		return 0.0;
+
+	return sum( c ) / ( (double) c.width() * c.height() );
+}
+
+} /* namespace SecurityCam */
@@ -0,0 +1,64 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef SECURITYCAM_INTEGRAL_HPP_INCLUDED
+#define SECURITYCAM_INTEGRAL_HPP_INCLUDED
+
+// Qt include.
+#include <QRect>
+
+// C++ include.
+#include <vector>
+
+
+namespace SecurityCam {
+
+//
+// IntegralImage
+//
+
+//! Summed-area table. Sum and mean of any rectangle are O(1).
+class IntegralImage final {
+public:
+	IntegralImage();
+
+	//! \return Is table empty.
+	bool isEmpty() const;
+	//! \return Width of the source.
+	int width() const;
+	//! \return Height of the source.
+	int height() const;
+
+	//! Build table of width x height values, row of values starts at
+	//! data + y * stride.
+	void build( const float * data, int width, int height, int stride );
+	//! Build table of width x height bytes, byte of pixel x is at
+	//! line[ x * pixelStride ], line starts at data + y * bytesPerLine.
+	void build( const uchar * data, int width, int height, int bytesPerLine,
+		int pixelStride );
+
+	//! \return Sum of values in the rectangle, rectangle is clipped.
+	double sum( const QRect & r ) const;
+	//! \return Mean of values in the rectangle, rectangle is clipped.
+	double mean( const QRect & r ) const;
+
+private:
+	//! Resize table.
+	void resize( int width, int height );
+	//! Add previous row of table to the row y.
+	void accumulate( int y );
+
+	//! Width.
+	int m_width;
+	//! Height.
+	int m_height;
+	//! Table of ( width + 1 ) x ( height + 1 ), first row and column are 0.
+	std::vector< double > m_table;
+}; // class IntegralImage
+
+} /* namespace SecurityCam */
+
+#endif // SECURITYCAM_INTEGRAL_HPP_INCLUDED
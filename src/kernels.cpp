@@ -0,0 +1,1140 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include "kernels.hpp"
+
+// Qt include.
+#include <QStringList>
+
+// C++ include.
+#include <cmath>
+#include <cstring>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+	#define SECURITYCAM_X86
+	#include <immintrin.h>
+
+	#if defined( _MSC_VER )
+		#include <intrin.h>
+	#endif
+#endif
+
+#if defined( __aarch64__ ) || defined( _M_ARM64 )
+	#define SECURITYCAM_NEON
+	#include <arm_neon.h>
+#endif
+
+// GCC and Clang compile variants for instruction sets not enabled for the
+// whole build, MSVC compiles intrinsics of any set without options.
+#if defined( __GNUC__ )
+	#define SECURITYCAM_TARGET( isa ) __attribute__( ( target( isa ) ) )
+#else
+	#define SECURITYCAM_TARGET( isa )
+#endif
+
+
+namespace SecurityCam {
+
+//
+// Isa
+//
+
+QString
+isaName( Isa isa )
+{
+	switch( isa )
+	{
+		case Isa::Sse2 :
+			return QStringLiteral( "sse2" );
+
+		case Isa::Avx2 :
+			return QStringLiteral( "avx2" );
+
+		case Isa::Avx512 :
+			return QStringLiteral( "avx512" );
+
+		case Isa::Neon :
+			return QStringLiteral( "neon" );
+
+		default :
+			return QStringLiteral( "generic" );
+	}
+}
+
+bool
+isaFromName( const QString & name, Isa & isa )
+{
+	// Ranks of sets of different architectures are equal, so only sets of
+	// this build are accepted.
+	for( const auto i : {
+		Isa::Generic,
+#ifdef SECURITYCAM_X86
+		Isa::Sse2, Isa::Avx2, Isa::Avx512,
+#endif
+#ifdef SECURITYCAM_NEON
+		Isa::Neon
+#endif
+		} )
+	{
+		if( isaName( i ) == name.toLower() )
+		{
+			isa = i;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+#ifdef SECURITYCAM_X86
+
+//! \return Is x86 instruction set supported by CPU and OS.
+static bool
+isX86Supported( Isa isa )
+{
+#if defined( _MSC_VER )
+	int info[ 4 ] = {};
+
+	__cpuid( info, 1 );
+
+	const bool sse2 = ( info[ 3 ] & ( 1 << 26 ) ) != 0;
+	const bool osxsave = ( info[ 2 ] & ( 1 << 27 ) ) != 0;
+	const unsigned long long xcr0 = ( osxsave ? _xgetbv( 0 ) : 0 );
+
+	__cpuidex( info, 7, 0 );
+
+	switch( isa )
+	{
+		case Isa::Sse2 :
+			return sse2;
+
+		case Isa::Avx2 :
+			return ( ( xcr0 & 0x06 ) == 0x06 && ( info[ 1 ] & ( 1 << 5 ) ) != 0 );
+
+		case Isa::Avx512 :
+			return ( ( xcr0 & 0xE6 ) == 0xE6 && ( info[ 1 ] & ( 1 << 16 ) ) != 0 );
+
+		default :
+			return false;
+	}
+#else
+	__builtin_cpu_init();
+
+	switch( isa )
+	{
+		case Isa::Sse2 :
+			return __builtin_cpu_supports( "sse2" );
+
+		case Isa::Avx2 :
+			return __builtin_cpu_supports( "avx2" );
+
+		case Isa::Avx512 :
+			return __builtin_cpu_supports( "avx512f" );
+
+		default :
+			return false;
+	}
+#endif
+}
+
+#endif // SECURITYCAM_X86
+
+bool
+isSupported( Isa isa )
+{
+	switch( isa )
+	{
+		case Isa::Generic :
+			return true;
+
+#ifdef SECURITYCAM_X86
+		case Isa::Sse2 :
+		case Isa::Avx2 :
+		case Isa::Avx512 :
+		{
+			static const bool sse2 = isX86Supported( Isa::Sse2 );
+			static const bool avx2 = isX86Supported( Isa::Avx2 );
+			static const bool avx512 = isX86Supported( Isa::Avx512 );
+
+			return ( isa == Isa::Sse2 ? sse2 : ( isa == Isa::Avx2 ? avx2 : avx512 ) );
+		}
+#endif
+
+#ifdef SECURITYCAM_NEON
+		// ASIMD is mandatory on AArch64.
+		case Isa::Neon :
+			return true;
+#endif
+
+		default :
+			return false;
+	}
+}
+
+//! \return Rank of the instruction set, variant with higher rank is preferred.
+static int
+isaRank( Isa isa )
+{
+	switch( isa )
+	{
+		case Isa::Sse2 :
+		case Isa::Neon :
+			return 1;
+
+		case Isa::Avx2 :
+			return 2;
+
+		case Isa::Avx512 :
+			return 3;
+
+		default :
+			return 0;
+	}
+}
+
+
+//
+// Variant
+//
+
+//! Implementation of the kernel.
+template< typename Func >
+struct Variant {
+	//! Instruction set.
+	Isa m_isa;
+	//! Function.
+	Func m_func;
+}; // struct Variant
+
+//! Choose the best supported variant not better than the limit. The last
+//! variant should be generic.
+template< typename Func, int N >
+static void
+choose( const Variant< Func > ( & variants )[ N ], Isa limit, Func & func, Isa & isa )
+{
+	func = variants[ N - 1 ].m_func;
+	isa = variants[ N - 1 ].m_isa;
+
+	for( const auto & v : variants )
+	{
+		if( isSupported( v.m_isa ) && isaRank( v.m_isa ) <= isaRank( limit ) &&
+			isaRank( v.m_isa ) > isaRank( isa ) )
+		{
+			func = v.m_func;
+			isa = v.m_isa;
+		}
+	}
+}
+
+
+//
+// differenceRow
+//
+
+static double
+differenceRowGeneric( const uchar * key, const uchar * image, float * pixels,
+	int width, float gain, float offset )
+{
+	const quint32 * k = reinterpret_cast< const quint32* > ( key );
+	const quint32 * i = reinterpret_cast< const quint32* > ( image );
+	const float scale = 1.0f / 255.0f;
+	const float g = gain * scale;
+
+	double sum = 0.0;
+
+	for( int x = 0; x < width; ++x )
+	{
+		const float b = ( k[ x ] & 0xFF ) * scale -
+			( ( i[ x ] & 0xFF ) * g + offset );
+		const float gr = ( ( k[ x ] >> 8 ) & 0xFF ) * scale -
+			( ( ( i[ x ] >> 8 ) & 0xFF ) * g + offset );
+		const float r = ( ( k[ x ] >> 16 ) & 0xFF ) * scale -
+			( ( ( i[ x ] >> 16 ) & 0xFF ) * g + offset );
+
+		const float e = std::sqrt( r * r + gr * gr + b * b );
+
+		sum += e;
+
+		if( pixels )
+			pixels[ x ] = e;
+	}
+
+	return sum;
+}
+
+#ifdef SECURITYCAM_X86
+
+SECURITYCAM_TARGET( "sse2" )
+static double
+differenceRowSse2( const uchar * key, const uchar * image, float * pixels,
+	int width, float gain, float offset )
+{
+	const __m128i mask = _mm_set1_epi32( 0xFF );
+	const __m128 scale = _mm_set1_ps( 1.0f / 255.0f );
+	const __m128 g = _mm_set1_ps( gain / 255.0f );
+	const __m128 o = _mm_set1_ps( offset );
+
+	__m128 sum = _mm_setzero_ps();
+
+	int x = 0;
+
+	for( ; x + 4 <= width; x += 4 )
+	{
+		const __m128i k = _mm_loadu_si128( reinterpret_cast< const __m128i* > ( key + x * 4 ) );
+		const __m128i i = _mm_loadu_si128( reinterpret_cast< const __m128i* > ( image + x * 4 ) );
+
+		__m128 e = _mm_setzero_ps();
+
+		for( int shift = 0; shift < 24; shift += 8 )
+		{
+			const __m128 kc = _mm_cvtepi32_ps( _mm_and_si128(
+				_mm_srl_epi32( k, _mm_cvtsi32_si128( shift ) ), mask ) );
+			const __m128 ic = _mm_cvtepi32_ps( _mm_and_si128(
+				_mm_srl_epi32( i, _mm_cvtsi32_si128( shift ) ), mask ) );
+			const __m128 d = _mm_sub_ps( _mm_mul_ps( kc, scale ),
+				_mm_add_ps( _mm_mul_ps( ic, g ), o ) );
+
+			e = _mm_add_ps( e, _mm_mul_ps( d, d ) );
+		}
+
+		e = _mm_sqrt_ps( e );
+
+		if( pixels )
+			_mm_storeu_ps( pixels + x, e );
+
+		sum = _mm_add_ps( sum, e );
+	}
+
+	float lanes[ 4 ];
+	_mm_storeu_ps( lanes, sum );
+
+	return (double) lanes[ 0 ] + lanes[ 1 ] + lanes[ 2 ] + lanes[ 3 ] +
+		differenceRowGeneric( key + x * 4, image + x * 4,
+			( pixels ? pixels + x : nullptr ), width - x, gain, offset );
+}
+
+SECURITYCAM_TARGET( "avx2" )
+static double
+differenceRowAvx2( const uchar * key, const uchar * image, float * pixels,
+	int width, float gain, float offset )
+{
+	const __m256i mask = _mm256_set1_epi32( 0xFF );
+	const __m256 scale = _mm256_set1_ps( 1.0f / 255.0f );
+	const __m256 g = _mm256_set1_ps( gain / 255.0f );
+	const __m256 o = _mm256_set1_ps( offset );
+
+	__m256 sum = _mm256_setzero_ps();
+
+	int x = 0;
+
+	for( ; x + 8 <= width; x += 8 )
+	{
+		const __m256i k = _mm256_loadu_si256( reinterpret_cast< const __m256i* > ( key + x * 4 ) );
+		const __m256i i = _mm256_loadu_si256( reinterpret_cast< const __m256i* > ( image + x * 4 ) );
+
+		__m256 e = _mm256_setzero_ps();
+
+		for( int shift = 0; shift < 24; shift += 8 )
+		{
+			const __m256 kc = _mm256_cvtepi32_ps( _mm256_and_si256(
+				_mm256_srl_epi32( k, _mm_cvtsi32_si128( shift ) ), mask ) );
+			const __m256 ic = _mm256_cvtepi32_ps( _mm256_and_si256(
+				_mm256_srl_epi32( i, _mm_cvtsi32_si128( shift ) ), mask ) );
+			const __m256 d = _mm256_sub_ps( _mm256_mul_ps( kc, scale ),
+				_mm256_add_ps( _mm256_mul_ps( ic, g ), o ) );
+
+			e = _mm256_add_ps( e, _mm256_mul_ps( d, d ) );
+		}
+
+		e = _mm256_sqrt_ps( e );
+
+		if( pixels )
+			_mm256_storeu_ps( pixels + x, e );
+
+		sum = _mm256_add_ps( sum, e );
+	}
+
+	float lanes[ 8 ];
+	_mm256_storeu_ps( lanes, sum );
+
+	double res = 0.0;
+
+	for( const auto l : lanes )
+		res += l;
+
+	return res + differenceRowGeneric( key + x * 4, image + x * 4,
+		( pixels ? pixels + x : nullptr ), width - x, gain, offset );
+}
+
+SECURITYCAM_TARGET( "avx512f" )
+static double
+differenceRowAvx512( const uchar * key, const uchar * image, float * pixels,
+	int width, float gain, float offset )
+{
+	const __m512i mask = _mm512_set1_epi32( 0xFF );
+	const __m512 scale = _mm512_set1_ps( 1.0f / 255.0f );
+	const __m512 g = _mm512_set1_ps( gain / 255.0f );
+	const __m512 o = _mm512_set1_ps( offset );
+
+	__m512 sum = _mm512_setzero_ps();
+
+	int x = 0;
+
+	for( ; x + 16 <= width; x += 16 )
+	{
+		const __m512i k = _mm512_loadu_si512( key + x * 4 );
+		const __m512i i = _mm512_loadu_si512( image + x * 4 );
+
+		__m512 e = _mm512_setzero_ps();
+
+		for( int shift = 0; shift < 24; shift += 8 )
+		{
+			const __m512 kc = _mm512_cvtepi32_ps( _mm512_and_si512(
+				_mm512_srl_epi32( k, _mm_cvtsi32_si128( shift ) ), mask ) );
+			const __m512 ic = _mm512_cvtepi32_ps( _mm512_and_si512(
+				_mm512_srl_epi32( i, _mm_cvtsi32_si128( shift ) ), mask ) );
+			const __m512 d = _mm512_sub_ps( _mm512_mul_ps( kc, scale ),
+				_mm512_add_ps( _mm512_mul_ps( ic, g ), o ) );
+
+			e = _mm512_add_ps( e, _mm512_mul_ps( d, d ) );
+		}
+
+		e = _mm512_sqrt_ps( e );
+
+		if( pixels )
+			_mm512_storeu_ps( pixels + x, e );
+
+		sum = _mm512_add_ps( sum, e );
+	}
+
+	return (double) _mm512_reduce_add_ps( sum ) +
+		differenceRowGeneric( key + x * 4, image + x * 4,
+			( pixels ? pixels + x : nullptr ), width - x, gain, offset );
+}
+
+#endif // SECURITYCAM_X86
+
+#ifdef SECURITYCAM_NEON
+
+static double
+differenceRowNeon( const uchar * key, const uchar * image, float * pixels,
+	int width, float gain, float offset )
+{
+	const uint32x4_t mask = vdupq_n_u32( 0xFF );
+	const float32x4_t scale = vdupq_n_f32( 1.0f / 255.0f );
+	const float32x4_t g = vdupq_n_f32( gain / 255.0f );
+	const float32x4_t o = vdupq_n_f32( offset );
+
+	float32x4_t sum = vdupq_n_f32( 0.0f );
+
+	int x = 0;
+
+	for( ; x + 4 <= width; x += 4 )
+	{
+		const uint32x4_t k = vld1q_u32( reinterpret_cast< const uint32_t* > ( key + x * 4 ) );
+		const uint32x4_t i = vld1q_u32( reinterpret_cast< const uint32_t* > ( image + x * 4 ) );
+
+		const float32x4_t db = vsubq_f32( vmulq_f32( vcvtq_f32_u32( vandq_u32( k, mask ) ), scale ),
+			vmlaq_f32( o, vcvtq_f32_u32( vandq_u32( i, mask ) ), g ) );
+		const float32x4_t dg = vsubq_f32( vmulq_f32( vcvtq_f32_u32(
+				vandq_u32( vshrq_n_u32( k, 8 ), mask ) ), scale ),
+			vmlaq_f32( o, vcvtq_f32_u32( vandq_u32( vshrq_n_u32( i, 8 ), mask ) ), g ) );
+		const float32x4_t dr = vsubq_f32( vmulq_f32( vcvtq_f32_u32(
+				vandq_u32( vshrq_n_u32( k, 16 ), mask ) ), scale ),
+			vmlaq_f32( o, vcvtq_f32_u32( vandq_u32( vshrq_n_u32( i, 16 ), mask ) ), g ) );
+
+		const float32x4_t e = vsqrtq_f32( vmlaq_f32( vmlaq_f32(
+			vmulq_f32( db, db ), dg, dg ), dr, dr ) );
+
+		if( pixels )
+			vst1q_f32( pixels + x, e );
+
+		sum = vaddq_f32( sum, e );
+	}
+
+	return (double) vaddvq_f32( sum ) +
+		differenceRowGeneric( key + x * 4, image + x * 4,
+			( pixels ? pixels + x : nullptr ), width - x, gain, offset );
+}
+
+#endif // SECURITYCAM_NEON
+
+static const Variant< DifferenceRow > c_differenceRow[] = {
+#ifdef SECURITYCAM_X86
+	{ Isa::Avx512, &differenceRowAvx512 },
+	{ Isa::Avx2, &differenceRowAvx2 },
+	{ Isa::Sse2, &differenceRowSse2 },
+#endif
+#ifdef SECURITYCAM_NEON
+	{ Isa::Neon, &differenceRowNeon },
+#endif
+	{ Isa::Generic, &differenceRowGeneric }
+};
+
+
+//
+// boxRow
+//
+
+static void
+boxRowGeneric( const uchar * line, const int * xs, int width, quint32 * acc )
+{
+	for( int x = 0; x < width; ++x, acc += 4 )
+	{
+		const int x1 = qMax( xs[ x ] + 1, xs[ x + 1 ] );
+
+		for( const uchar * p = line + xs[ x ] * 4, * end = line + x1 * 4;
+			p != end; p += 4 )
+		{
+			acc[ 0 ] += p[ 0 ];
+			acc[ 1 ] += p[ 1 ];
+			acc[ 2 ] += p[ 2 ];
+			acc[ 3 ] += p[ 3 ];
+		}
+	}
+}
+
+//! Maximum width of the box summed in 16-bit lanes. Lanes of even and odd
+//! pixels are added together, so the whole box should fit in 16 bits.
+static const int c_maxBox = 65535 / 255;
+
+#ifdef SECURITYCAM_X86
+
+SECURITYCAM_TARGET( "sse2" )
+static void
+boxRowSse2( const uchar * line, const int * xs, int width, quint32 * acc )
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	for( int x = 0; x < width; ++x, acc += 4 )
+	{
+		const int x1 = qMax( xs[ x ] + 1, xs[ x + 1 ] );
+
+		if( x1 - xs[ x ] > c_maxBox )
+		{
+			boxRowGeneric( line, xs + x, 1, acc );
+
+			continue;
+		}
+
+		__m128i a = _mm_loadu_si128( reinterpret_cast< const __m128i* > ( acc ) );
+		__m128i pairs = zero;
+
+		const uchar * p = line + xs[ x ] * 4;
+		const uchar * end = line + x1 * 4;
+
+		// Two pixels at once in 16-bit lanes.
+		for( ; p + 8 <= end; p += 8 )
+			pairs = _mm_add_epi16( pairs, _mm_unpacklo_epi8(
+				_mm_loadl_epi64( reinterpret_cast< const __m128i* > ( p ) ), zero ) );
+
+		pairs = _mm_add_epi16( pairs, _mm_srli_si128( pairs, 8 ) );
+
+		if( p != end )
+		{
+			int v = 0;
+			memcpy( &v, p, 4 );
+
+			pairs = _mm_add_epi16( pairs,
+				_mm_unpacklo_epi8( _mm_cvtsi32_si128( v ), zero ) );
+		}
+
+		a = _mm_add_epi32( a, _mm_unpacklo_epi16( pairs, zero ) );
+
+		_mm_storeu_si128( reinterpret_cast< __m128i* > ( acc ), a );
+	}
+}
+
+#endif // SECURITYCAM_X86
+
+#ifdef SECURITYCAM_NEON
+
+static void
+boxRowNeon( const uchar * line, const int * xs, int width, quint32 * acc )
+{
+	for( int x = 0; x < width; ++x, acc += 4 )
+	{
+		const int x1 = qMax( xs[ x ] + 1, xs[ x + 1 ] );
+
+		if( x1 - xs[ x ] > c_maxBox )
+		{
+			boxRowGeneric( line, xs + x, 1, acc );
+
+			continue;
+		}
+
+		uint16x8_t pairs = vdupq_n_u16( 0 );
+
+		const uchar * p = line + xs[ x ] * 4;
+		const uchar * end = line + x1 * 4;
+
+		// Two pixels at once in 16-bit lanes.
+		for( ; p + 8 <= end; p += 8 )
+			pairs = vaddw_u8( pairs, vld1_u8( p ) );
+
+		uint16x4_t sum = vadd_u16( vget_low_u16( pairs ), vget_high_u16( pairs ) );
+
+		if( p != end )
+		{
+			uint8x8_t v = vdup_n_u8( 0 );
+			v = vreinterpret_u8_u32( vld1_lane_u32(
+				reinterpret_cast< const uint32_t* > ( p ),
+				vreinterpret_u32_u8( v ), 0 ) );
+
+			sum = vadd_u16( sum, vget_low_u16( vmovl_u8( v ) ) );
+		}
+
+		vst1q_u32( acc, vaddw_u16( vld1q_u32( acc ), sum ) );
+	}
+}
+
+#endif // SECURITYCAM_NEON
+
+static const Variant< BoxRow > c_boxRow[] = {
+#ifdef SECURITYCAM_X86
+	{ Isa::Sse2, &boxRowSse2 },
+#endif
+#ifdef SECURITYCAM_NEON
+	{ Isa::Neon, &boxRowNeon },
+#endif
+	{ Isa::Generic, &boxRowGeneric }
+};
+
+
+//
+// yuvMatrix
+//
+
+YuvMatrix
+yuvMatrix( bool bt709, bool fullRange )
+{
+	// Kr and Kb of the standard.
+	const float kr = ( bt709 ? 0.2126f : 0.299f );
+	const float kb = ( bt709 ? 0.0722f : 0.114f );
+	const float kg = 1.0f - kr - kb;
+	const float chroma = ( fullRange ? 1.0f : 255.0f / 224.0f );
+
+	YuvMatrix m;
+	m.m_yOffset = ( fullRange ? 0.0f : 16.0f );
+	m.m_yScale = ( fullRange ? 1.0f : 255.0f / 219.0f );
+	m.m_rv = 2.0f * ( 1.0f - kr ) * chroma;
+	m.m_bu = 2.0f * ( 1.0f - kb ) * chroma;
+	m.m_gu = -kb * 2.0f * ( 1.0f - kb ) / kg * chroma;
+	m.m_gv = -kr * 2.0f * ( 1.0f - kr ) / kg * chroma;
+
+	return m;
+}
+
+
+//
+// YUV rows
+//
+
+//! \return Channel rounded and clamped to 0..255.
+static inline quint32
+clampChannel( float v )
+{
+	return ( v <= 0.0f ? 0 : ( v >= 255.0f ? 255 : (quint32) ( v + 0.5f ) ) );
+}
+
+//! Store pixel of YUV as 32-bit RGB.
+static inline void
+storeRgb( uchar * out, int y, int u, int v, const YuvMatrix & m )
+{
+	const float l = ( y - m.m_yOffset ) * m.m_yScale;
+	const float cu = u - 128.0f;
+	const float cv = v - 128.0f;
+
+	*reinterpret_cast< quint32* > ( out ) = 0xFF000000u |
+		( clampChannel( l + m.m_rv * cv ) << 16 ) |
+		( clampChannel( l + m.m_gu * cu + m.m_gv * cv ) << 8 ) |
+		clampChannel( l + m.m_bu * cu );
+}
+
+static void
+nv12RowGeneric( const uchar * y, const uchar * uv, uchar * out, int width,
+	const YuvMatrix & m )
+{
+	int x = 0;
+
+	for( ; x + 2 <= width; x += 2, out += 8 )
+	{
+		storeRgb( out, y[ x ], uv[ x ], uv[ x + 1 ], m );
+		storeRgb( out + 4, y[ x + 1 ], uv[ x ], uv[ x + 1 ], m );
+	}
+
+	if( x < width )
+		storeRgb( out, y[ x ], uv[ x ], uv[ x + 1 ], m );
+}
+
+//! Packed 4:2:2 with the given offsets of the first luma, U and V.
+template< int Y, int U, int V >
+static void
+packedRowGeneric( const uchar * line, uchar * out, int width, const YuvMatrix & m )
+{
+	int x = 0;
+
+	for( ; x + 2 <= width; x += 2, line += 4, out += 8 )
+	{
+		storeRgb( out, line[ Y ], line[ U ], line[ V ], m );
+		storeRgb( out + 4, line[ Y + 2 ], line[ U ], line[ V ], m );
+	}
+
+	if( x < width )
+		storeRgb( out, line[ Y ], line[ U ], line[ V ], m );
+}
+
+static void
+yuv420RowGeneric( const uchar * y, const uchar * u, const uchar * v, uchar * out,
+	int width, const YuvMatrix & m )
+{
+	int x = 0;
+
+	for( ; x + 2 <= width; x += 2, out += 8 )
+	{
+		storeRgb( out, y[ x ], u[ x / 2 ], v[ x / 2 ], m );
+		storeRgb( out + 4, y[ x + 1 ], u[ x / 2 ], v[ x / 2 ], m );
+	}
+
+	if( x < width )
+		storeRgb( out, y[ x ], u[ x / 2 ], v[ x / 2 ], m );
+}
+
+#ifdef SECURITYCAM_X86
+
+//! Split interleaved chroma in 16-bit lanes, U0 V0 U1 V1..., to U0 U0 U1 U1...
+//! and V0 V0 V1 V1...
+SECURITYCAM_TARGET( "sse2" )
+static inline void
+splitChromaSse2( __m128i c, __m128i & u, __m128i & v )
+{
+	const __m128i uw = _mm_and_si128( c, _mm_set1_epi32( 0xFFFF ) );
+	const __m128i vw = _mm_srli_epi32( c, 16 );
+
+	u = _mm_or_si128( uw, _mm_slli_epi32( uw, 16 ) );
+	v = _mm_or_si128( vw, _mm_slli_epi32( vw, 16 ) );
+}
+
+//! Pack 8 channels of 32-bit to bytes and store 8 pixels as 32-bit RGB.
+SECURITYCAM_TARGET( "sse2" )
+static inline void
+storePixelsSse2( __m128i r0, __m128i r1, __m128i g0, __m128i g1, __m128i b0,
+	__m128i b1, uchar * out )
+{
+	const __m128i r = _mm_packus_epi16( _mm_packs_epi32( r0, r1 ), _mm_setzero_si128() );
+	const __m128i g = _mm_packus_epi16( _mm_packs_epi32( g0, g1 ), _mm_setzero_si128() );
+	const __m128i b = _mm_packus_epi16( _mm_packs_epi32( b0, b1 ), _mm_setzero_si128() );
+
+	const __m128i bg = _mm_unpacklo_epi8( b, g );
+	const __m128i ra = _mm_unpacklo_epi8( r, _mm_set1_epi8( (char) 0xFF ) );
+
+	_mm_storeu_si128( reinterpret_cast< __m128i* > ( out ), _mm_unpacklo_epi16( bg, ra ) );
+	_mm_storeu_si128( reinterpret_cast< __m128i* > ( out + 16 ), _mm_unpackhi_epi16( bg, ra ) );
+}
+
+//! Store 8 pixels of YUV in 16-bit lanes as 32-bit RGB.
+SECURITYCAM_TARGET( "sse2" )
+static inline void
+storeRgbSse2( __m128i y, __m128i u, __m128i v, const YuvMatrix & m, uchar * out )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 yOffset = _mm_set1_ps( m.m_yOffset );
+	const __m128 yScale = _mm_set1_ps( m.m_yScale );
+	const __m128 half = _mm_set1_ps( 128.0f );
+
+	__m128i r[ 2 ], g[ 2 ], b[ 2 ];
+
+	for( int i = 0; i < 2; ++i )
+	{
+		const __m128i y32 = ( i == 0 ? _mm_unpacklo_epi16( y, zero ) : _mm_unpackhi_epi16( y, zero ) );
+		const __m128i u32 = ( i == 0 ? _mm_unpacklo_epi16( u, zero ) : _mm_unpackhi_epi16( u, zero ) );
+		const __m128i v32 = ( i == 0 ? _mm_unpacklo_epi16( v, zero ) : _mm_unpackhi_epi16( v, zero ) );
+
+		const __m128 l = _mm_mul_ps( _mm_sub_ps( _mm_cvtepi32_ps( y32 ), yOffset ), yScale );
+		const __m128 cu = _mm_sub_ps( _mm_cvtepi32_ps( u32 ), half );
+		const __m128 cv = _mm_sub_ps( _mm_cvtepi32_ps( v32 ), half );
+
+		r[ i ] = _mm_cvtps_epi32( _mm_add_ps( l, _mm_mul_ps( cv, _mm_set1_ps( m.m_rv ) ) ) );
+		g[ i ] = _mm_cvtps_epi32( _mm_add_ps( l, _mm_add_ps(
+			_mm_mul_ps( cu, _mm_set1_ps( m.m_gu ) ), _mm_mul_ps( cv, _mm_set1_ps( m.m_gv ) ) ) ) );
+		b[ i ] = _mm_cvtps_epi32( _mm_add_ps( l, _mm_mul_ps( cu, _mm_set1_ps( m.m_bu ) ) ) );
+	}
+
+	storePixelsSse2( r[ 0 ], r[ 1 ], g[ 0 ], g[ 1 ], b[ 0 ], b[ 1 ], out );
+}
+
+//! Store 8 pixels of YUV in 16-bit lanes as 32-bit RGB, math in 256 bits.
+SECURITYCAM_TARGET( "avx2" )
+static inline void
+storeRgbAvx2( __m128i y, __m128i u, __m128i v, const YuvMatrix & m, uchar * out )
+{
+	const __m256 l = _mm256_mul_ps( _mm256_sub_ps( _mm256_cvtepi32_ps( _mm256_cvtepu16_epi32( y ) ),
+		_mm256_set1_ps( m.m_yOffset ) ), _mm256_set1_ps( m.m_yScale ) );
+	const __m256 cu = _mm256_sub_ps( _mm256_cvtepi32_ps( _mm256_cvtepu16_epi32( u ) ),
+		_mm256_set1_ps( 128.0f ) );
+	const __m256 cv = _mm256_sub_ps( _mm256_cvtepi32_ps( _mm256_cvtepu16_epi32( v ) ),
+		_mm256_set1_ps( 128.0f ) );
+
+	const __m256i r = _mm256_cvtps_epi32( _mm256_add_ps( l,
+		_mm256_mul_ps( cv, _mm256_set1_ps( m.m_rv ) ) ) );
+	const __m256i g = _mm256_cvtps_epi32( _mm256_add_ps( l, _mm256_add_ps(
+		_mm256_mul_ps( cu, _mm256_set1_ps( m.m_gu ) ),
+		_mm256_mul_ps( cv, _mm256_set1_ps( m.m_gv ) ) ) ) );
+	const __m256i b = _mm256_cvtps_epi32( _mm256_add_ps( l,
+		_mm256_mul_ps( cu, _mm256_set1_ps( m.m_bu ) ) ) );
+
+	storePixelsSse2( _mm256_castsi256_si128( r ), _mm256_extracti128_si256( r, 1 ),
+		_mm256_castsi256_si128( g ), _mm256_extracti128_si256( g, 1 ),
+		_mm256_castsi256_si128( b ), _mm256_extracti128_si256( b, 1 ), out );
+}
+
+//! Rows of YUV formats with the given store of 8 pixels.
+#define SECURITYCAM_YUV_ROWS( isa, target, store ) \
+\
+SECURITYCAM_TARGET( target ) \
+static void \
+nv12Row##isa( const uchar * y, const uchar * uv, uchar * out, int width, \
+	const YuvMatrix & m ) \
+{ \
+	const __m128i zero = _mm_setzero_si128(); \
+\
+	int x = 0; \
+\
+	for( ; x + 8 <= width; x += 8 ) \
+	{ \
+		__m128i u, v; \
+		splitChromaSse2( _mm_unpacklo_epi8( _mm_loadl_epi64( \
+			reinterpret_cast< const __m128i* > ( uv + x ) ), zero ), u, v ); \
+\
+		store( _mm_unpacklo_epi8( _mm_loadl_epi64( \
+			reinterpret_cast< const __m128i* > ( y + x ) ), zero ), u, v, m, out + x * 4 ); \
+	} \
+\
+	nv12RowGeneric( y + x, uv + x, out + x * 4, width - x, m ); \
+} \
+\
+template< bool LumaFirst > \
+SECURITYCAM_TARGET( target ) \
+static void \
+packedRow##isa( const uchar * line, uchar * out, int width, const YuvMatrix & m ) \
+{ \
+	const __m128i low = _mm_set1_epi16( 0xFF ); \
+\
+	int x = 0; \
+\
+	for( ; x + 8 <= width; x += 8 ) \
+	{ \
+		const __m128i p = _mm_loadu_si128( \
+			reinterpret_cast< const __m128i* > ( line + x * 2 ) ); \
+		const __m128i l = ( LumaFirst ? _mm_and_si128( p, low ) : _mm_srli_epi16( p, 8 ) ); \
+		const __m128i c = ( LumaFirst ? _mm_srli_epi16( p, 8 ) : _mm_and_si128( p, low ) ); \
+\
+		__m128i u, v; \
+		splitChromaSse2( c, u, v ); \
+\
+		store( l, u, v, m, out + x * 4 ); \
+	} \
+\
+	if( LumaFirst ) \
+		packedRowGeneric< 0, 1, 3 >( line + x * 2, out + x * 4, width - x, m ); \
+	else \
+		packedRowGeneric< 1, 0, 2 >( line + x * 2, out + x * 4, width - x, m ); \
+} \
+\
+SECURITYCAM_TARGET( target ) \
+static void \
+yuv420Row##isa( const uchar * y, const uchar * u, const uchar * v, uchar * out, \
+	int width, const YuvMatrix & m ) \
+{ \
+	const __m128i zero = _mm_setzero_si128(); \
+\
+	int x = 0; \
+\
+	for( ; x + 8 <= width; x += 8 ) \
+	{ \
+		int uw = 0; \
+		int vw = 0; \
+		memcpy( &uw, u + x / 2, 4 ); \
+		memcpy( &vw, v + x / 2, 4 ); \
+\
+		const __m128i u16 = _mm_unpacklo_epi8( _mm_cvtsi32_si128( uw ), zero ); \
+		const __m128i v16 = _mm_unpacklo_epi8( _mm_cvtsi32_si128( vw ), zero ); \
+\
+		store( _mm_unpacklo_epi8( _mm_loadl_epi64( \
+				reinterpret_cast< const __m128i* > ( y + x ) ), zero ), \
+			_mm_unpacklo_epi16( u16, u16 ), _mm_unpacklo_epi16( v16, v16 ), m, out + x * 4 ); \
+	} \
+\
+	yuv420RowGeneric( y + x, u + x / 2, v + x / 2, out + x * 4, width - x, m ); \
+}
+
+SECURITYCAM_YUV_ROWS( Sse2, "sse2", storeRgbSse2 )
+SECURITYCAM_YUV_ROWS( Avx2, "avx2", storeRgbAvx2 )
+
+#endif // SECURITYCAM_X86
+
+#ifdef SECURITYCAM_NEON
+
+//! Split interleaved chroma in 16-bit lanes, U0 V0 U1 V1..., to U0 U0 U1 U1...
+//! and V0 V0 V1 V1...
+static inline void
+splitChromaNeon( uint16x8_t c, uint16x8_t & u, uint16x8_t & v )
+{
+	const uint32x4_t c32 = vreinterpretq_u32_u16( c );
+	const uint32x4_t uw = vandq_u32( c32, vdupq_n_u32( 0xFFFF ) );
+	const uint32x4_t vw = vshrq_n_u32( c32, 16 );
+
+	u = vreinterpretq_u16_u32( vorrq_u32( uw, vshlq_n_u32( uw, 16 ) ) );
+	v = vreinterpretq_u16_u32( vorrq_u32( vw, vshlq_n_u32( vw, 16 ) ) );
+}
+
+//! \return 4 channels rounded to 32-bit.
+static inline int32x4_t
+channelNeon( float32x4_t v )
+{
+	return vcvtnq_s32_f32( v );
+}
+
+//! Store 8 pixels of YUV in 16-bit lanes as 32-bit RGB.
+static inline void
+storeRgbNeon( uint16x8_t y, uint16x8_t u, uint16x8_t v, const YuvMatrix & m,
+	uchar * out )
+{
+	int32x4_t r[ 2 ], g[ 2 ], b[ 2 ];
+
+	for( int i = 0; i < 2; ++i )
+	{
+		const uint16x4_t y4 = ( i == 0 ? vget_low_u16( y ) : vget_high_u16( y ) );
+		const uint16x4_t u4 = ( i == 0 ? vget_low_u16( u ) : vget_high_u16( u ) );
+		const uint16x4_t v4 = ( i == 0 ? vget_low_u16( v ) : vget_high_u16( v ) );
+
+		const float32x4_t l = vmulq_n_f32( vsubq_f32( vcvtq_f32_u32( vmovl_u16( y4 ) ),
+			vdupq_n_f32( m.m_yOffset ) ), m.m_yScale );
+		const float32x4_t cu = vsubq_f32( vcvtq_f32_u32( vmovl_u16( u4 ) ),
+			vdupq_n_f32( 128.0f ) );
+		const float32x4_t cv = vsubq_f32( vcvtq_f32_u32( vmovl_u16( v4 ) ),
+			vdupq_n_f32( 128.0f ) );
+
+		r[ i ] = channelNeon( vmlaq_n_f32( l, cv, m.m_rv ) );
+		g[ i ] = channelNeon( vmlaq_n_f32( vmlaq_n_f32( l, cu, m.m_gu ), cv, m.m_gv ) );
+		b[ i ] = channelNeon( vmlaq_n_f32( l, cu, m.m_bu ) );
+	}
+
+	uint8x8x4_t px;
+	px.val[ 0 ] = vqmovun_s16( vcombine_s16( vqmovn_s32( b[ 0 ] ), vqmovn_s32( b[ 1 ] ) ) );
+	px.val[ 1 ] = vqmovun_s16( vcombine_s16( vqmovn_s32( g[ 0 ] ), vqmovn_s32( g[ 1 ] ) ) );
+	px.val[ 2 ] = vqmovun_s16( vcombine_s16( vqmovn_s32( r[ 0 ] ), vqmovn_s32( r[ 1 ] ) ) );
+	px.val[ 3 ] = vdup_n_u8( 0xFF );
+
+	vst4_u8( out, px );
+}
+
+static void
+nv12RowNeon( const uchar * y, const uchar * uv, uchar * out, int width,
+	const YuvMatrix & m )
+{
+	int x = 0;
+
+	for( ; x + 8 <= width; x += 8 )
+	{
+		uint16x8_t u, v;
+		splitChromaNeon( vmovl_u8( vld1_u8( uv + x ) ), u, v );
+
+		storeRgbNeon( vmovl_u8( vld1_u8( y + x ) ), u, v, m, out + x * 4 );
+	}
+
+	nv12RowGeneric( y + x, uv + x, out + x * 4, width - x, m );
+}
+
+template< bool LumaFirst >
+static void
+packedRowNeon( const uchar * line, uchar * out, int width, const YuvMatrix & m )
+{
+	const uint16x8_t low = vdupq_n_u16( 0xFF );
+
+	int x = 0;
+
+	for( ; x + 8 <= width; x += 8 )
+	{
+		const uint16x8_t p = vreinterpretq_u16_u8( vld1q_u8( line + x * 2 ) );
+		const uint16x8_t l = ( LumaFirst ? vandq_u16( p, low ) : vshrq_n_u16( p, 8 ) );
+		const uint16x8_t c = ( LumaFirst ? vshrq_n_u16( p, 8 ) : vandq_u16( p, low ) );
+
+		uint16x8_t u, v;
+		splitChromaNeon( c, u, v );
+
+		storeRgbNeon( l, u, v, m, out + x * 4 );
+	}
+
+	if( LumaFirst )
+		packedRowGeneric< 0, 1, 3 >( line + x * 2, out + x * 4, width - x, m );
+	else
+		packedRowGeneric< 1, 0, 2 >( line + x * 2, out + x * 4, width - x, m );
+}
+
+static void
+yuv420RowNeon( const uchar * y, const uchar * u, const uchar * v, uchar * out,
+	int width, const YuvMatrix & m )
+{
+	int x = 0;
+
+	for( ; x + 8 <= width; x += 8 )
+	{
+		uint32_t uw = 0;
+		uint32_t vw = 0;
+		memcpy( &uw, u + x / 2, 4 );
+		memcpy( &vw, v + x / 2, 4 );
+
+		const uint16x8_t u16 = vmovl_u8( vreinterpret_u8_u32( vdup_n_u32( uw ) ) );
+		const uint16x8_t v16 = vmovl_u8( vreinterpret_u8_u32( vdup_n_u32( vw ) ) );
+
+		storeRgbNeon( vmovl_u8( vld1_u8( y + x ) ), vzipq_u16( u16, u16 ).val[ 0 ],
+			vzipq_u16( v16, v16 ).val[ 0 ], m, out + x * 4 );
+	}
+
+	yuv420RowGeneric( y + x, u + x / 2, v + x / 2, out + x * 4, width - x, m );
+}
+
+#endif // SECURITYCAM_NEON
+
+static const Variant< Nv12Row > c_nv12Row[] = {
+#ifdef SECURITYCAM_X86
+	{ Isa::Avx2, &nv12RowAvx2 },
+	{ Isa::Sse2, &nv12RowSse2 },
+#endif
+#ifdef SECURITYCAM_NEON
+	{ Isa::Neon, &nv12RowNeon },
+#endif
+	{ Isa::Generic, &nv12RowGeneric }
+};
+
+static const Variant< PackedRow > c_yuyvRow[] = {
+#ifdef SECURITYCAM_X86
+	{ Isa::Avx2, &packedRowAvx2< true > },
+	{ Isa::Sse2, &packedRowSse2< true > },
+#endif
+#ifdef SECURITYCAM_NEON
+	{ Isa::Neon, &packedRowNeon< true > },
+#endif
+	{ Isa::Generic, &packedRowGeneric< 0, 1, 3 > }
+};
+
+static const Variant< PackedRow > c_uyvyRow[] = {
+#ifdef SECURITYCAM_X86
+	{ Isa::Avx2, &packedRowAvx2< false > },
+	{ Isa::Sse2, &packedRowSse2< false > },
+#endif
+#ifdef SECURITYCAM_NEON
+	{ Isa::Neon, &packedRowNeon< false > },
+#endif
+	{ Isa::Generic, &packedRowGeneric< 1, 0, 2 > }
+};
+
+static const Variant< PlanarRow > c_yuv420Row[] = {
+#ifdef SECURITYCAM_X86
+	{ Isa::Avx2, &yuv420RowAvx2 },
+	{ Isa::Sse2, &yuv420RowSse2 },
+#endif
+#ifdef SECURITYCAM_NEON
+	{ Isa::Neon, &yuv420RowNeon },
+#endif
+	{ Isa::Generic, &yuv420RowGeneric }
+};
+
+
+//
+// Kernels
+//
+
+Kernels::Kernels()
+{
+	select( Isa::Avx512 );
+}
+
+Kernels &
+Kernels::instance()
+{
+	static Kernels kernels;
+
+	return kernels;
+}
+
+void
+Kernels::select( Isa limit )
+{
+	choose( c_differenceRow, limit, m_differenceRow, m_differenceRowIsa );
+	choose( c_boxRow, limit, m_boxRow, m_boxRowIsa );
+	choose( c_nv12Row, limit, m_nv12Row, m_nv12RowIsa );
+	choose( c_yuyvRow, limit, m_yuyvRow, m_yuyvRowIsa );
+	choose( c_uyvyRow, limit, m_uyvyRow, m_uyvyRowIsa );
+	choose( c_yuv420Row, limit, m_yuv420Row, m_yuv420RowIsa );
+}
+
+QVector< QPair< QString, Isa > >
+Kernels::selected() const
+{
+	QVector< QPair< QString, Isa > > res;
+
+	res.append( qMakePair( QStringLiteral( "difference" ), m_differenceRowIsa ) );
+	res.append( qMakePair( QStringLiteral( "box" ), m_boxRowIsa ) );
+	res.append( qMakePair( QStringLiteral( "nv12" ), m_nv12RowIsa ) );
+	res.append( qMakePair( QStringLiteral( "yuyv" ), m_yuyvRowIsa ) );
+	res.append( qMakePair( QStringLiteral( "uyvy" ), m_uyvyRowIsa ) );
+	res.append( qMakePair( QStringLiteral( "yuv420" ), m_yuv420RowIsa ) );
+
+	return res;
+}
+
+QString
+Kernels::description() const
+{
+	QStringList res;
+
+	for( const auto & k : selected() )
+		res.append( k.first + QLatin1Char( '=' ) + isaName( k.second ) );
+
+	return res.join( QLatin1Char( ' ' ) );
+}
+
+DifferenceRow
+Kernels::differenceRow() const
+{
+	return m_differenceRow;
+}
+
+BoxRow
+Kernels::boxRow() const
+{
+	return m_boxRow;
+}
+
+Nv12Row
+Kernels::nv12Row() const
+{
+	return m_nv12Row;
+}
+
+PackedRow
+Kernels::yuyvRow() const
+{
+	return m_yuyvRow;
+}
+
+PackedRow
+Kernels::uyvyRow() const
+{
+	return m_uyvyRow;
+}
+
+PlanarRow
+Kernels::yuv420Row() const
+{
+	return m_yuv420Row;
+}
+
+} /* namespace SecurityCam */
@@ -0,0 +1,169 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef SECURITYCAM_KERNELS_HPP_INCLUDED
+#define SECURITYCAM_KERNELS_HPP_INCLUDED
+
+// Qt include.
+#include <QString>
+#include <QVector>
+#include <QPair>
+
+
+namespace SecurityCam {
+
+//
+// Isa
+//
+
+//! Instruction set of the kernel.
+enum class Isa {
+	//! Plain C++.
+	Generic,
+	//! x86 SSE2.
+	Sse2,
+	//! x86 AVX2.
+	Avx2,
+	//! x86 AVX-512 (F).
+	Avx512,
+	//! ARM NEON (ASIMD).
+	Neon
+}; // enum class Isa
+
+//! \return Name of the instruction set.
+QString
+isaName( Isa isa );
+
+//! Find instruction set of the architecture of this build by name.
+//! \return Is name known for this architecture.
+bool
+isaFromName( const QString & name, Isa & isa );
+
+//! \return Is instruction set supported by this CPU and by this build.
+bool
+isSupported( Isa isa );
+
+
+//
+// Kernel types
+//
+
+//! Difference of row of 32-bit RGB pixels of the key frame and of image with
+//! gain and offset applied to the row of image, see imagesDifference().
+//! Pixels may be null. \return Sum of differences.
+typedef double ( * DifferenceRow )( const uchar * key, const uchar * image,
+	float * pixels, int width, float gain, float offset );
+
+//! Add line of 32-bit pixels to accumulators of boxes of destination, box x
+//! covers source pixels from xs[ x ] to max( xs[ x ] + 1, xs[ x + 1 ] ).
+typedef void ( * BoxRow )( const uchar * line, const int * xs, int width,
+	quint32 * acc );
+
+
+//
+// YuvMatrix
+//
+
+//! Coefficients of conversion of YUV to RGB, chroma is centered at 128.
+struct YuvMatrix {
+	//! Offset of luma.
+	float m_yOffset;
+	//! Scale of luma.
+	float m_yScale;
+	//! V to red.
+	float m_rv;
+	//! U to green.
+	float m_gu;
+	//! V to green.
+	float m_gv;
+	//! U to blue.
+	float m_bu;
+}; // struct YuvMatrix
+
+//! \return Coefficients of BT.601 or BT.709 in full or limited range.
+YuvMatrix
+yuvMatrix( bool bt709, bool fullRange );
+
+//! Convert row of semi-planar 4:2:0 (NV12) to 32-bit RGB.
+typedef void ( * Nv12Row )( const uchar * y, const uchar * uv, uchar * out,
+	int width, const YuvMatrix & m );
+
+//! Convert row of packed 4:2:2 (YUYV or UYVY) to 32-bit RGB.
+typedef void ( * PackedRow )( const uchar * line, uchar * out, int width,
+	const YuvMatrix & m );
+
+//! Convert row of planar 4:2:0 (YUV420P) to 32-bit RGB.
+typedef void ( * PlanarRow )( const uchar * y, const uchar * u, const uchar * v,
+	uchar * out, int width, const YuvMatrix & m );
+
+
+//
+// Kernels
+//
+
+//! Registry of image kernels. The best implementation supported by CPU is
+//! chosen on first use, select() may limit it for testing.
+class Kernels final {
+public:
+	//! \return Instance.
+	static Kernels & instance();
+
+	//! Select the best supported implementations not better than the limit.
+	//! Should be called before processing starts.
+	void select( Isa limit );
+
+	//! \return Names of kernels with chosen instruction sets.
+	QVector< QPair< QString, Isa > > selected() const;
+	//! \return Chosen instruction sets as "kernel=isa" separated with space.
+	QString description() const;
+
+	//! \return Difference of row.
+	DifferenceRow differenceRow() const;
+	//! \return Accumulation of row in box scaling.
+	BoxRow boxRow() const;
+	//! \return Conversion of row of NV12.
+	Nv12Row nv12Row() const;
+	//! \return Conversion of row of YUYV.
+	PackedRow yuyvRow() const;
+	//! \return Conversion of row of UYVY.
+	PackedRow uyvyRow() const;
+	//! \return Conversion of row of YUV420P.
+	PlanarRow yuv420Row() const;
+
+private:
+	Kernels();
+
+	Q_DISABLE_COPY( Kernels )
+
+	//! Difference of row.
+	DifferenceRow m_differenceRow;
+	//! Instruction set of difference of row.
+	Isa m_differenceRowIsa;
+	//! Accumulation of row.
+	BoxRow m_boxRow;
+	//! Instruction set of accumulation of row.
+	Isa m_boxRowIsa;
+	//! Conversion of NV12.
+	Nv12Row m_nv12Row;
+	//! Instruction set of conversion of NV12.
+	Isa m_nv12RowIsa;
+	//! Conversion of YUYV.
+	PackedRow m_yuyvRow;
+	//! Instruction set of conversion of YUYV.
+	Isa m_yuyvRowIsa;
+	//! Conversion of UYVY.
+	PackedRow m_uyvyRow;
+	//! Instruction set of conversion of UYVY.
+	Isa m_uyvyRowIsa;
+	//! Conversion of YUV420P.
+	PlanarRow m_yuv420Row;
+	//! Instruction set of conversion of YUV420P.
+	Isa m_yuv420RowIsa;
+}; // class Kernels
+
+} /* namespace SecurityCam */
+
+#endif // SECURITYCAM_KERNELS_HPP_INCLUDED
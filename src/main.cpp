@@ -6,6 +6,8 @@
 
 // SecurityCam include.
 #include "mainwindow.hpp"
+#include "trace.hpp"
+#include "kernels.hpp"
 
 // Qt include.
 #include <QApplication>
@@ -19,18 +21,38 @@
 int main( int argc, char ** argv )
 {
 	QString cfgFileName;
+	QString traceFileName;
+	SecurityCam::Isa isa = SecurityCam::Isa::Avx512;
 
 	try {
 		Args::CmdLine cmd;
 
 		cmd.addArgWithFlagAndName( QLatin1Char( 'c' ), QLatin1String( "cfg" ),
 			true, false, QLatin1String( "Configuration file." ) )
+			.addArgWithFlagAndName( QLatin1Char( 't' ), QLatin1String( "trace" ),
+				true, false, QLatin1String( "Trace pipeline and save trace to the "
+					"given file on exit." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'i' ), QLatin1String( "isa" ),
+				true, false, QLatin1String( "Limit image kernels to the given "
+					"instruction set: generic, sse2, avx2, avx512 or neon." ) )
 			.addHelp( true, argv[ 0 ], QLatin1String( "Security USB camera." ) );
 
 		cmd.parse( argc, argv );
 
 		if( cmd.isDefined( QLatin1String( "-c" ) ) )
 			cfgFileName = cmd.value( QLatin1String( "-c" ) );
+
+		if( cmd.isDefined( QLatin1String( "-t" ) ) )
+			traceFileName = cmd.value( QLatin1String( "-t" ) );
+
+		if( cmd.isDefined( QLatin1String( "-i" ) ) &&
+			!SecurityCam::isaFromName( cmd.value( QLatin1String( "-i" ) ), isa ) )
+		{
+			qDebug() << "Unknown instruction set for this build:"
+				<< cmd.value( QLatin1String( "-i" ) );
+
+			return 1;
+		}
 	}
 	catch( const Args::HelpHasBeenPrintedException & )
 	{
@@ -43,6 +65,11 @@ int main( int argc, char ** argv )
 		return 1;
 	}
 
+	SecurityCam::Kernels::instance().select( isa );
+
+	qInfo() << "Image kernels:"
+		<< qPrintable( SecurityCam::Kernels::instance().description() );
+
 	QApplication app( argc, argv );
 
 	QIcon appIcon( ":/logo/img/icon_256x256.png" );
@@ -62,9 +89,17 @@ int main( int argc, char ** argv )
 			QStandardPaths::writableLocation( QStandardPaths::AppConfigLocation ) +
 			QLatin1String( "/security-cam.cfg" );
 
+	if( !traceFileName.isEmpty() )
+		SecurityCam::Tracer::instance().setEnabled( true );
+
 	SecurityCam::MainWindow w( cfgFileName );
 	w.resize( 640, 480 );
 	w.show();
 
-	return app.exec();
+	const int ret = app.exec();
+
+	if( !traceFileName.isEmpty() )
+		SecurityCam::Tracer::instance().dump( traceFileName );
+
+	return ret;
 }
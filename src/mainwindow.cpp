@@ -9,9 +9,13 @@
 #include "cfg.hpp"
 #include "options.hpp"
 #include "frames.hpp"
-#include "view.hpp"
+#include "gridview.hpp"
 #include "resolution.hpp"
 #include "license_dialog.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+#include "preview.hpp"
+#include "devices.hpp"
 
 // cfgfile include.
 #include <cfgfile/all.hpp>
@@ -32,6 +36,9 @@
 #include <QFile>
 #include <QStatusBar>
 #include <QLabel>
+#include <QThread>
+#include <QFileDialog>
+#include <QFileSystemWatcher>
 
 
 namespace SecurityCam {
@@ -52,8 +59,12 @@ public:
 		,	m_timer( Q_NULLPTR )
 		,	m_cleanTimer( Q_NULLPTR )
 		,	m_frames( Q_NULLPTR )
-		,	m_view( Q_NULLPTR )
+		,	m_grid( Q_NULLPTR )
 		,	m_status( Q_NULLPTR )
+		,	m_metricsThread( Q_NULLPTR )
+		,	m_metricsServer( Q_NULLPTR )
+		,	m_watcher( Q_NULLPTR )
+		,	m_reloadTimer( Q_NULLPTR )
 		,	m_cfgFileName( cfgFileName )
 		,	q( parent )
 	{
@@ -63,10 +74,16 @@ public:
 	void init();
 	//! Read cfg.
 	bool readCfg();
+	//! Apply new cfg to the running pipeline, only changed settings are touched.
+	void applyCfg( const Cfg::Cfg & c );
+	//! Watch cfg file for changes.
+	void watchCfg();
 	//! Init camera.
 	void initCamera();
 	//! Init UI.
 	void initUi();
+	//! Init tile of the camera.
+	void initTile();
 	//! Save cfg.
 	void saveCfg();
 	//! Stop camera.
@@ -75,6 +92,14 @@ public:
 	void startCleanTimer();
 	//! Configure frames.
 	void configureFrames();
+	//! Configure transformation of frames.
+	void configureTransform();
+	//! Configure timeouts of recording.
+	void configureTimeouts();
+	//! Start metrics server.
+	void startMetrics();
+	//! Stop metrics server.
+	void stopMetrics();
 
 	//! System tray icon.
 	QSystemTrayIcon * m_sysTray;
@@ -97,9 +122,17 @@ public:
 	//! Surface.
 	Frames * m_frames;
 	//! View.
-	View * m_view;
+	GridView * m_grid;
 	//! Status label.
 	QLabel * m_status;
+	//! Metrics thread.
+	QThread * m_metricsThread;
+	//! Metrics server.
+	MetricsServer * m_metricsServer;
+	//! Watcher of cfg file.
+	QFileSystemWatcher * m_watcher;
+	//! Delay of reloading of cfg, editors write file in several steps.
+	QTimer * m_reloadTimer;
 	//! Configuration.
 	Cfg::Cfg m_cfg;
 	//! Cfg file.
@@ -120,18 +153,81 @@ MainWindowPrivate::init()
 		startCleanTimer();
 
 		configureFrames();
+
+		startMetrics();
 	}
 	else
 		q->options();
+
+	watchCfg();
+}
+
+void
+MainWindowPrivate::startMetrics()
+{
+	const QHostAddress address = ( m_cfg.metricsAddress().isEmpty() ?
+		QHostAddress( QHostAddress::LocalHost ) :
+		QHostAddress( m_cfg.metricsAddress() ) );
+	const quint16 port = static_cast< quint16 > ( m_cfg.metricsPort() );
+	MetricsServer * server = m_metricsServer;
+
+	QMetaObject::invokeMethod( m_metricsServer,
+		[server, address, port] () { server->listen( address, port ); },
+		Qt::QueuedConnection );
+}
+
+void
+MainWindowPrivate::stopMetrics()
+{
+	m_metricsThread->quit();
+	m_metricsThread->wait();
 }
 
 void
 MainWindowPrivate::configureFrames()
 {
-	m_takeImageInterval = m_cfg.snapshotTimeout();
+	configureTimeouts();
 
-	m_takeImagesYetInterval = m_cfg.stopTimeout();
+	configureTransform();
+
+	m_frames->setThreshold( m_cfg.threshold() );
+
+	m_frames->setBlobRules( m_cfg.blobThreshold(), m_cfg.minBlobArea(),
+		m_cfg.minBlobCount() );
+
+	m_frames->setLightCompensation( m_cfg.lightCompensation(),
+		m_cfg.lightingThreshold() );
+
+	m_frames->setTamperDetection( m_cfg.tamperDetection(), m_cfg.tamperDeviation(),
+		m_cfg.tamperSharpnessDrop(), m_cfg.tamperLumaChange(), m_cfg.tamperDuration() );
+
+	m_frames->setHysteresis( m_cfg.offThreshold(), m_cfg.motionConfirmations(),
+		m_cfg.motionWindow(), m_cfg.minEventDuration() );
+
+	m_frames->setProfileThresholds( m_cfg.dayThreshold(), m_cfg.nightThreshold() );
+
+	m_frames->setCalibrationRules( m_cfg.calibrationPercentile(),
+		m_cfg.calibrationMargin(), m_cfg.nightLuma() );
+
+	m_frames->setRollingCalibration( m_cfg.calibrationInterval() );
+
+	m_frames->setDetectionWidth( m_cfg.detectionWidth() );
+
+	m_frames->setBestFrame( m_cfg.bestFrame() );
+
+	m_frames->setDuplicateEpsilon( m_cfg.duplicateEpsilon() );
+
+	const auto fmt = Devices::instance().format( m_cam, m_cfg.resolution() );
+
+	if( !fmt.isNull() )
+		m_frames->setResolution( fmt );
 
+	m_frames->setIdleMode( m_cfg.idleTimeout(), m_cfg.idleResolution() );
+}
+
+void
+MainWindowPrivate::configureTransform()
+{
 	if( m_cfg.applyTransform() )
 	{
 		m_frames->setRotation( m_cfg.rotation() );
@@ -142,23 +238,134 @@ MainWindowPrivate::configureFrames()
 	}
 	else
 		m_frames->applyTransform( false );
+}
 
-	m_frames->setThreshold( m_cfg.threshold() );
+void
+MainWindowPrivate::configureTimeouts()
+{
+	m_takeImageInterval = m_cfg.snapshotTimeout();
+
+	m_takeImagesYetInterval = m_cfg.stopTimeout();
 
-	const auto settings = m_cam.videoFormats();
+	if( m_timer->isActive() && m_timer->interval() != m_takeImageInterval )
+		m_timer->setInterval( m_takeImageInterval );
+}
 
-	for( const auto & s : settings )
+//! \return Is resolutions the same.
+static bool
+isSameResolution( const Cfg::Resolution & r1, const Cfg::Resolution & r2 )
+{
+	return ( r1.width() == r2.width() && r1.height() == r2.height() &&
+		qAbs( r1.fps() - r2.fps() ) < 0.01 && r1.format() == r2.format() );
+}
+
+void
+MainWindowPrivate::applyCfg( const Cfg::Cfg & c )
+{
+	const Cfg::Cfg old = m_cfg;
+
+	m_cfg = c;
+
+	// Only change of the camera needs restart of the camera, Frames keeps
+	// threshold and transformation across restarts.
+	if( old.camera() != c.camera() )
 	{
-		if( s.resolution().width() == m_cfg.resolution().width() &&
-			s.resolution().height() == m_cfg.resolution().height() &&
-			qAbs( s.maxFrameRate() - m_cfg.resolution().fps() ) < 0.01 &&
-			s.pixelFormat() == stringToPixelFormat( m_cfg.resolution().format() ) )
-		{
-			m_frames->setResolution( s );
+		stopCamera();
 
-			break;
-		}
+		initCamera();
+	}
+	else if( !isSameResolution( old.resolution(), c.resolution() ) )
+	{
+		const auto fmt = Devices::instance().format( m_cam, m_cfg.resolution() );
+
+		if( !fmt.isNull() )
+			m_frames->setResolution( fmt );
 	}
+
+	if( old.threshold() != c.threshold() )
+		m_frames->setThreshold( c.threshold() );
+
+	if( old.blobThreshold() != c.blobThreshold() ||
+		old.minBlobArea() != c.minBlobArea() ||
+		old.minBlobCount() != c.minBlobCount() )
+			m_frames->setBlobRules( c.blobThreshold(), c.minBlobArea(),
+				c.minBlobCount() );
+
+	if( old.lightCompensation() != c.lightCompensation() ||
+		old.lightingThreshold() != c.lightingThreshold() )
+			m_frames->setLightCompensation( c.lightCompensation(),
+				c.lightingThreshold() );
+
+	if( old.tamperDetection() != c.tamperDetection() ||
+		old.tamperDeviation() != c.tamperDeviation() ||
+		old.tamperSharpnessDrop() != c.tamperSharpnessDrop() ||
+		old.tamperLumaChange() != c.tamperLumaChange() ||
+		old.tamperDuration() != c.tamperDuration() )
+			m_frames->setTamperDetection( c.tamperDetection(), c.tamperDeviation(),
+				c.tamperSharpnessDrop(), c.tamperLumaChange(), c.tamperDuration() );
+
+	if( old.dayThreshold() != c.dayThreshold() ||
+		old.nightThreshold() != c.nightThreshold() )
+			m_frames->setProfileThresholds( c.dayThreshold(), c.nightThreshold() );
+
+	if( old.calibrationPercentile() != c.calibrationPercentile() ||
+		old.calibrationMargin() != c.calibrationMargin() ||
+		old.nightLuma() != c.nightLuma() )
+			m_frames->setCalibrationRules( c.calibrationPercentile(),
+				c.calibrationMargin(), c.nightLuma() );
+
+	if( old.calibrationInterval() != c.calibrationInterval() )
+		m_frames->setRollingCalibration( c.calibrationInterval() );
+
+	if( old.offThreshold() != c.offThreshold() ||
+		old.motionConfirmations() != c.motionConfirmations() ||
+		old.motionWindow() != c.motionWindow() ||
+		old.minEventDuration() != c.minEventDuration() )
+			m_frames->setHysteresis( c.offThreshold(), c.motionConfirmations(),
+				c.motionWindow(), c.minEventDuration() );
+
+	if( old.idleTimeout() != c.idleTimeout() ||
+		!isSameResolution( old.idleResolution(), c.idleResolution() ) )
+			m_frames->setIdleMode( c.idleTimeout(), c.idleResolution() );
+
+	if( old.detectionWidth() != c.detectionWidth() )
+		m_frames->setDetectionWidth( c.detectionWidth() );
+
+	if( old.bestFrame() != c.bestFrame() )
+		m_frames->setBestFrame( c.bestFrame() );
+
+	if( old.duplicateEpsilon() != c.duplicateEpsilon() )
+		m_frames->setDuplicateEpsilon( c.duplicateEpsilon() );
+
+	if( old.applyTransform() != c.applyTransform() ||
+		old.rotation() != c.rotation() ||
+		old.mirrored() != c.mirrored() )
+			configureTransform();
+
+	if( old.snapshotTimeout() != c.snapshotTimeout() ||
+		old.stopTimeout() != c.stopTimeout() )
+			configureTimeouts();
+
+	if( old.storeDays() != c.storeDays() || old.clearTime() != c.clearTime() )
+		startCleanTimer();
+
+	if( old.metricsPort() != c.metricsPort() ||
+		old.metricsAddress() != c.metricsAddress() )
+			startMetrics();
+}
+
+void
+MainWindowPrivate::watchCfg()
+{
+	const QFileInfo info( m_cfgFileName );
+
+	if( info.exists() && !m_watcher->files().contains( m_cfgFileName ) )
+		m_watcher->addPath( m_cfgFileName );
+
+	// Editors often replace file, so watch directory to catch it back.
+	if( info.absoluteDir().exists() &&
+		!m_watcher->directories().contains( info.absolutePath() ) )
+			m_watcher->addPath( info.absolutePath() );
 }
 
 void
@@ -180,6 +387,19 @@ MainWindowPrivate::startCleanTimer()
 	}
 }
 
+//! Read cfg from the opened file, throws on error.
+static Cfg::Cfg
+readCfgFile( QFile & file, const QString & fileName )
+{
+	Cfg::tag_Cfg< cfgfile::qstring_trait_t > tag;
+
+	QTextStream stream( &file );
+
+	cfgfile::read_cfgfile( tag, stream, fileName );
+
+	return tag.get_cfg();
+}
+
 bool
 MainWindowPrivate::readCfg()
 {
@@ -190,16 +410,10 @@ MainWindowPrivate::readCfg()
 		if( file.open( QIODevice::ReadOnly ) )
 		{
 			try {
-				Cfg::tag_Cfg< cfgfile::qstring_trait_t > tag;
-
-				QTextStream stream( &file );
-
-				cfgfile::read_cfgfile( tag, stream, m_cfgFileName );
+				m_cfg = readCfgFile( file, m_cfgFileName );
 
 				file.close();
 
-				m_cfg = tag.get_cfg();
-
 				return true;
 			}
 			catch( const cfgfile::exception_t< cfgfile::qstring_trait_t > & x )
@@ -235,19 +449,46 @@ MainWindowPrivate::readCfg()
 
 static const int c_cameraReinitTimeout = 1000;
 
+//! Delay of reloading of changed cfg file.
+static const int c_cfgReloadDelay = 500;
+
 void
 MainWindowPrivate::initCamera()
 {
 	if( !m_cfg.camera().isEmpty() )
 	{
-		m_frames->initCam( m_cfg.camera() );
+		m_frames->initCam( m_cfg.camera(), m_cfg.resolution() );
 
 		m_cam = m_frames->cameraDevice();
 
+		initTile();
+
 		q->setStatusLabel();
 	}
 }
 
+void
+MainWindowPrivate::initTile()
+{
+	const QString camera = m_cam.description();
+
+	const auto cameras = m_grid->cameras();
+
+	for( const auto & c : cameras )
+	{
+		if( c != camera )
+			m_grid->removeCamera( c );
+	}
+
+	if( !cameras.contains( camera ) )
+	{
+		m_grid->addCamera( camera );
+
+		MainWindow::connect( m_frames, &Frames::newFrame,
+			m_grid->preview( camera ), &Preview::frame, Qt::DirectConnection );
+	}
+}
+
 void
 MainWindowPrivate::initUi()
 {
@@ -265,6 +506,23 @@ MainWindowPrivate::initUi()
 		MainWindow::tr( "&Resolution" ), q,
 		&MainWindow::resolution );
 
+	opts->addAction( MainWindow::tr( "Calibrate T&hreshold" ), q,
+		&MainWindow::calibrate );
+
+	opts->addSeparator();
+
+	QAction * overlay = opts->addAction( MainWindow::tr( "Motion &Overlay" ),
+		q, &MainWindow::overlay );
+	overlay->setCheckable( true );
+
+	QAction * trace = opts->addAction( MainWindow::tr( "&Trace Pipeline" ),
+		q, &MainWindow::trace );
+	trace->setCheckable( true );
+	trace->setChecked( Tracer::isEnabled() );
+
+	opts->addAction( MainWindow::tr( "Save T&race..." ), q,
+		&MainWindow::saveTrace );
+
 	QMenu * help = q->menuBar()->addMenu( MainWindow::tr( "&Help" ) );
 	help->addAction( QIcon( ":/logo/img/icon_22x22.png" ),
 		MainWindow::tr( "About" ), q, &MainWindow::about );
@@ -310,9 +568,9 @@ MainWindowPrivate::initUi()
 
 	m_frames = new Frames( m_cfg, q );
 
-	m_view = new View( q );
+	m_grid = new GridView( q );
 
-	q->setCentralWidget( m_view );
+	q->setCentralWidget( m_grid );
 
 	m_stopTimer = new QTimer( q );
 
@@ -325,8 +583,33 @@ MainWindowPrivate::initUi()
 
 	q->statusBar()->addPermanentWidget( m_status );
 
-	MainWindow::connect( m_frames, &Frames::newFrame,
-		m_view, &View::draw, Qt::QueuedConnection );
+	m_metricsThread = new QThread( q );
+
+	m_metricsServer = new MetricsServer;
+	m_metricsServer->moveToThread( m_metricsThread );
+
+	MainWindow::connect( m_metricsThread, &QThread::finished,
+		m_metricsServer, &QObject::deleteLater );
+
+	m_metricsThread->start();
+
+	m_watcher = new QFileSystemWatcher( q );
+
+	m_reloadTimer = new QTimer( q );
+	m_reloadTimer->setSingleShot( true );
+	m_reloadTimer->setInterval( c_cfgReloadDelay );
+
+	MainWindow::connect( m_watcher, &QFileSystemWatcher::fileChanged,
+		q, &MainWindow::cfgFileChanged );
+	MainWindow::connect( m_watcher, &QFileSystemWatcher::directoryChanged,
+		q, &MainWindow::cfgDirChanged );
+	MainWindow::connect( m_reloadTimer, &QTimer::timeout,
+		q, &MainWindow::reloadCfg );
+
+	MainWindow::connect( m_grid, &GridView::tileChanged,
+		q, &MainWindow::tileChanged );
+	MainWindow::connect( m_frames, &Frames::motionMap,
+		q, &MainWindow::motionMap );
 	MainWindow::connect( m_frames, &Frames::motionDetected,
 		q, &MainWindow::motionDetected, Qt::QueuedConnection );
 	MainWindow::connect( m_frames, &Frames::noMoreMotions,
@@ -339,6 +622,18 @@ MainWindowPrivate::initUi()
 		q, &MainWindow::clean );
 	MainWindow::connect( m_frames, &Frames::fps,
 		q, &MainWindow::fps, Qt::QueuedConnection );
+	MainWindow::connect( m_frames, &Frames::formatSwitched,
+		q, &MainWindow::formatSwitched, Qt::QueuedConnection );
+	MainWindow::connect( m_frames, &Frames::lightingChanged,
+		q, &MainWindow::lightingChanged, Qt::QueuedConnection );
+	MainWindow::connect( m_frames, &Frames::noFrames,
+		q, &MainWindow::noFrames, Qt::QueuedConnection );
+	MainWindow::connect( m_frames, &Frames::reconnected,
+		q, &MainWindow::reconnected, Qt::QueuedConnection );
+	MainWindow::connect( m_frames, &Frames::tamperDetected,
+		q, &MainWindow::tamperDetected, Qt::QueuedConnection );
+	MainWindow::connect( m_frames, &Frames::calibrated,
+		q, &MainWindow::calibrated, Qt::QueuedConnection );
 }
 
 void
@@ -401,6 +696,7 @@ MainWindow::MainWindow( const QString & cfgFileName )
 
 MainWindow::~MainWindow() noexcept
 {
+	d->stopMetrics();
 }
 
 void
@@ -423,32 +719,17 @@ MainWindow::options()
 
 	if( QDialog::Accepted == opts.exec() )
 	{
-		const Cfg::Cfg c = opts.cfg();
-
-		bool reinit = false;
+		Cfg::Cfg c = opts.cfg();
 
 		if( d->m_cfg.camera() != c.camera() )
 		{
-			reinit = true;
-
-			d->m_cfg.resolution().set_width( 0 );
-			d->m_cfg.resolution().set_height( 0 );
+			c.resolution().set_width( 0 );
+			c.resolution().set_height( 0 );
 		}
 
-		d->m_cfg = c;
-
-		d->startCleanTimer();
+		d->applyCfg( c );
 
 		d->saveCfg();
-
-		if( reinit )
-		{
-			d->stopCamera();
-
-			d->initCamera();
-		}
-
-		d->configureFrames();
 	}
 	else if( d->m_cfg.camera().isEmpty() )
 	{
@@ -461,6 +742,51 @@ MainWindow::options()
 		d->saveCfg();
 
 		d->configureFrames();
+
+		d->startMetrics();
+
+		d->watchCfg();
+	}
+}
+
+void
+MainWindow::cfgFileChanged( const QString & )
+{
+	d->watchCfg();
+
+	d->m_reloadTimer->start();
+}
+
+void
+MainWindow::cfgDirChanged( const QString & )
+{
+	// Cfg file was created or replaced.
+	if( QFileInfo::exists( d->m_cfgFileName ) &&
+		!d->m_watcher->files().contains( d->m_cfgFileName ) )
+			cfgFileChanged( d->m_cfgFileName );
+}
+
+void
+MainWindow::reloadCfg()
+{
+	QFile file( d->m_cfgFileName );
+
+	if( !file.open( QIODevice::ReadOnly ) )
+		return;
+
+	try {
+		const Cfg::Cfg c = readCfgFile( file, d->m_cfgFileName );
+
+		file.close();
+
+		d->applyCfg( c );
+	}
+	catch( const cfgfile::exception_t< cfgfile::qstring_trait_t > & x )
+	{
+		file.close();
+
+		statusBar()->showMessage( tr( "Configuration is not reloaded: %1" )
+			.arg( x.desc() ), 5000 );
 	}
 }
 
@@ -524,6 +850,8 @@ MainWindow::stopRecording()
 
 	d->m_timer->stop();
 
+	d->m_frames->stopImages();
+
 	d->m_isRecording = false;
 }
 
@@ -839,6 +1167,8 @@ MainWindow::clean()
 
 	QDir folder( d->m_cfg.folder() );
 
+	quint64 removed = 0;
+
 	QStringList years = folder.entryList( QDir::Dirs | QDir::NoDotAndDotDot );
 
 	foreach( const QString & y, years )
@@ -881,7 +1211,8 @@ MainWindow::clean()
 								QLatin1String( "/" ) + m +
 								QLatin1String( "/" ) + dd );
 
-							r.removeRecursively();
+							if( r.removeRecursively() )
+								++removed;
 						}
 					}
 
@@ -898,6 +1229,14 @@ MainWindow::clean()
 				year.removeRecursively();
 		}
 	}
+
+	CameraMetrics * metrics = d->m_frames->metrics();
+
+	if( metrics )
+	{
+		++metrics->m_retentionRuns;
+		metrics->m_retentionRemoved += removed;
+	}
 }
 
 void
@@ -916,7 +1255,135 @@ MainWindow::setStatusLabel()
 	d->m_status->setText( tr( "%1x%2 | %3 fps" )
 		.arg( s.resolution().width() )
 		.arg( s.resolution().height() )
-		.arg( d->m_fps ) );
+		.arg( d->m_fps ) +
+		( d->m_frames->isIdle() ? tr( " | idle" ) : QString() ) );
+}
+
+void
+MainWindow::calibrate()
+{
+	d->m_frames->startCalibration( d->m_cfg.calibrationTime() );
+
+	statusBar()->showMessage( tr( "Calibrating threshold, keep the scene quiet "
+		"for %1 seconds..." ).arg( d->m_cfg.calibrationTime() ),
+		d->m_cfg.calibrationTime() * 1000 );
+}
+
+void
+MainWindow::calibrated( qreal day, qreal night )
+{
+	if( day > 0.0 )
+		d->m_cfg.set_dayThreshold( day );
+
+	if( night > 0.0 )
+		d->m_cfg.set_nightThreshold( night );
+
+	if( day > 0.0 || night > 0.0 )
+	{
+		d->saveCfg();
+
+		statusBar()->showMessage( tr( "Threshold calibrated: day %1, night %2." )
+			.arg( d->m_cfg.dayThreshold(), 0, 'f', 5 )
+			.arg( d->m_cfg.nightThreshold(), 0, 'f', 5 ), 5000 );
+	}
+	else
+		statusBar()->showMessage(
+			tr( "Threshold is not calibrated, not enough frames." ), 5000 );
+}
+
+void
+MainWindow::lightingChanged()
+{
+	statusBar()->showMessage( tr( "Lighting of the scene changed." ), 5000 );
+}
+
+void
+MainWindow::noFrames()
+{
+	statusBar()->showMessage( tr( "No frames from camera, reconnecting..." ) );
+}
+
+void
+MainWindow::reconnected( qint64 msecs )
+{
+	d->m_cam = d->m_frames->cameraDevice();
+
+	// Camera may be missing on start.
+	d->initTile();
+
+	statusBar()->showMessage( tr( "Camera reconnected after %1 s without frames." )
+		.arg( (double) msecs / 1000.0, 0, 'f', 1 ), 5000 );
+
+	setStatusLabel();
+}
+
+void
+MainWindow::tamperDetected( int reasons )
+{
+	QStringList what;
+
+	if( reasons & Tamper::Covered )
+		what.append( tr( "covered" ) );
+
+	if( reasons & Tamper::Defocused )
+		what.append( tr( "defocused" ) );
+
+	if( reasons & Tamper::SceneChanged )
+		what.append( tr( "turned away" ) );
+
+	statusBar()->showMessage( tr( "Camera is tampered: %1." )
+		.arg( what.join( QStringLiteral( ", " ) ) ) );
+}
+
+void
+MainWindow::formatSwitched( bool idle, qint64 usecs )
+{
+	statusBar()->showMessage( ( idle ? tr( "Switched to idle format in %1 ms." ) :
+		tr( "Switched to full format in %1 ms." ) )
+			.arg( (double) usecs / 1000.0, 0, 'f', 1 ), 5000 );
+
+	setStatusLabel();
+}
+
+void
+MainWindow::overlay( bool on )
+{
+	d->m_grid->setOverlayEnabled( on );
+}
+
+void
+MainWindow::motionMap( const MotionMap & map )
+{
+	d->m_grid->setMotionMap( d->m_cam.description(), map );
+}
+
+void
+MainWindow::tileChanged( const QString & camera, const QSize & s, int interval )
+{
+	if( camera == d->m_cam.description() )
+	{
+		d->m_frames->setPreviewEnabled( !s.isEmpty() );
+		d->m_frames->setPreviewInterval( interval );
+		d->m_frames->setPreviewSize( s );
+	}
+}
+
+void
+MainWindow::trace( bool on )
+{
+	Tracer::instance().setEnabled( on );
+}
+
+void
+MainWindow::saveTrace()
+{
+	const QString fileName = QFileDialog::getSaveFileName( this,
+		tr( "Save trace..." ), QString(), tr( "Chrome trace (*.json)" ) );
+
+	if( !fileName.isEmpty() && !Tracer::instance().dump( fileName ) )
+		QMessageBox::critical( this, tr( "Unable to save trace..." ),
+			tr( "Unable to save trace.\n"
+				"Unable to open file \"%1\"." ).arg( fileName ) );
 }
 
 } /* namespace SecurityCam */
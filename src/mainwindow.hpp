@@ -13,6 +13,9 @@
 #include <QSystemTrayIcon>
 #include <QCamera>
 
+// SecurityCam include.
+#include "detector.hpp"
+
 
 namespace SecurityCam {
 
@@ -61,6 +64,36 @@ private slots:
 	void fps( int v );
 	//! Set status label.
 	void setStatusLabel();
+	//! Enable or disable tracing.
+	void trace( bool on );
+	//! Save trace.
+	void saveTrace();
+	//! Enable or disable overlay with motion.
+	void overlay( bool on );
+	//! Map of motion updated.
+	void motionMap( const SecurityCam::MotionMap & map );
+	//! Tile of the camera changed.
+	void tileChanged( const QString & camera, const QSize & s, int interval );
+	//! Cfg file changed.
+	void cfgFileChanged( const QString & path );
+	//! Directory of cfg file changed.
+	void cfgDirChanged( const QString & path );
+	//! Reload cfg file.
+	void reloadCfg();
+	//! Format of the camera switched.
+	void formatSwitched( bool idle, qint64 usecs );
+	//! Lighting of the scene changed.
+	void lightingChanged();
+	//! No frames from camera.
+	void noFrames();
+	//! Camera reconnected after outage.
+	void reconnected( qint64 msecs );
+	//! Camera is tampered.
+	void tamperDetected( int reasons );
+	//! Start calibration of threshold.
+	void calibrate();
+	//! Threshold calibrated.
+	void calibrated( qreal day, qreal night );
 
 
 protected:
@@ -0,0 +1,428 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include "metrics.hpp"
+#include "kernels.hpp"
+
+// Qt include.
+#include <QMutexLocker>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+
+namespace SecurityCam {
+
+//
+// Histogram
+//
+
+//! Upper bounds of buckets in seconds.
+static const double c_bounds[ Histogram::c_bucketsCount ] = {
+	0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+	0.05, 0.1, 0.25, 0.5, 1.0, 2.5 };
+
+Histogram::Histogram()
+	:	m_count( 0 )
+	,	m_sum( 0 )
+{
+	for( auto & b : m_buckets )
+		b.store( 0, std::memory_order_relaxed );
+}
+
+void
+Histogram::observe( qint64 usecs )
+{
+	if( usecs < 0 )
+		usecs = 0;
+
+	const double s = (double) usecs / 1000000.0;
+
+	int i = 0;
+
+	while( i < c_bucketsCount && s > c_bounds[ i ] )
+		++i;
+
+	m_buckets[ i ].fetch_add( 1, std::memory_order_relaxed );
+	m_sum.fetch_add( (quint64) usecs, std::memory_order_relaxed );
+	m_count.fetch_add( 1, std::memory_order_relaxed );
+}
+
+double
+Histogram::bound( int bucket )
+{
+	return c_bounds[ bucket ];
+}
+
+quint64
+Histogram::bucket( int i ) const
+{
+	return m_buckets[ i ].load( std::memory_order_relaxed );
+}
+
+quint64
+Histogram::count() const
+{
+	return m_count.load( std::memory_order_relaxed );
+}
+
+quint64
+Histogram::sum() const
+{
+	return m_sum.load( std::memory_order_relaxed );
+}
+
+
+//
+// CameraMetrics
+//
+
+CameraMetrics::CameraMetrics( const QString & camera )
+	:	m_deliveredFrames( 0 )
+	,	m_analysedFrames( 0 )
+	,	m_unmappedFrames( 0 )
+	,	m_droppedFrames( 0 )
+	,	m_previewDropped( 0 )
+	,	m_deliveredFps( 0 )
+	,	m_analysedFps( 0 )
+	,	m_motionEvents( 0 )
+	,	m_lightingChanges( 0 )
+	,	m_tamperEvents( 0 )
+	,	m_captureQueue( 0 )
+	,	m_imagesWritten( 0 )
+	,	m_bytesWritten( 0 )
+	,	m_imagesSuppressed( 0 )
+	,	m_retentionRuns( 0 )
+	,	m_retentionRemoved( 0 )
+	,	m_formatSwitches( 0 )
+	,	m_idle( 0 )
+	,	m_outages( 0 )
+	,	m_outageMsecs( 0 )
+	,	m_camera( camera )
+{
+}
+
+const QString &
+CameraMetrics::camera() const
+{
+	return m_camera;
+}
+
+
+//
+// Metrics
+//
+
+Metrics::Metrics()
+{
+}
+
+Metrics::~Metrics()
+{
+	qDeleteAll( m_cameras );
+}
+
+Metrics &
+Metrics::instance()
+{
+	static Metrics metrics;
+
+	return metrics;
+}
+
+CameraMetrics *
+Metrics::camera( const QString & name )
+{
+	QMutexLocker lock( &m_mutex );
+
+	for( const auto & c : qAsConst( m_cameras ) )
+	{
+		if( c->camera() == name )
+			return c;
+	}
+
+	m_cameras.append( new CameraMetrics( name ) );
+
+	return m_cameras.last();
+}
+
+//! \return Escaped label value.
+static QByteArray
+escapeLabel( const QString & v )
+{
+	QByteArray res = v.toUtf8();
+
+	res.replace( '\\', "\\\\" );
+	res.replace( '"', "\\\"" );
+	res.replace( '\n', "\\n" );
+
+	return res;
+}
+
+//! Write HELP and TYPE lines.
+static void
+writeHeader( QByteArray & out, const char * name, const char * type,
+	const char * help )
+{
+	out.append( "# HELP " ).append( name ).append( ' ' ).append( help )
+		.append( "\n# TYPE " ).append( name ).append( ' ' ).append( type )
+		.append( '\n' );
+}
+
+//! Write sample.
+static void
+writeSample( QByteArray & out, const char * name, const QByteArray & labels,
+	const QByteArray & value )
+{
+	out.append( name ).append( '{' ).append( labels ).append( "} " )
+		.append( value ).append( '\n' );
+}
+
+QByteArray
+Metrics::exposition() const
+{
+	QList< CameraMetrics* > cameras;
+
+	{
+		QMutexLocker lock( &m_mutex );
+
+		cameras = m_cameras;
+	}
+
+	QByteArray out;
+
+	const auto counter = [&] ( const char * name, const char * help,
+		const std::atomic< quint64 > CameraMetrics::* field )
+	{
+		writeHeader( out, name, "counter", help );
+
+		for( const auto & c : qAsConst( cameras ) )
+			writeSample( out, name,
+				"camera=\"" + escapeLabel( c->camera() ) + '"',
+				QByteArray::number( ( c->*field ).load( std::memory_order_relaxed ) ) );
+	};
+
+	const auto gauge = [&] ( const char * name, const char * help,
+		const std::atomic< int > CameraMetrics::* field )
+	{
+		writeHeader( out, name, "gauge", help );
+
+		for( const auto & c : qAsConst( cameras ) )
+			writeSample( out, name,
+				"camera=\"" + escapeLabel( c->camera() ) + '"',
+				QByteArray::number( ( c->*field ).load( std::memory_order_relaxed ) ) );
+	};
+
+	const auto histogram = [&] ( const char * name, const char * help,
+		const Histogram CameraMetrics::* field )
+	{
+		writeHeader( out, name, "histogram", help );
+
+		const QByteArray bucket = QByteArray( name ) + "_bucket";
+
+		for( const auto & c : qAsConst( cameras ) )
+		{
+			const Histogram & h = c->*field;
+			const QByteArray camera = "camera=\"" + escapeLabel( c->camera() ) + '"';
+
+			quint64 cumulative = 0;
+
+			for( int i = 0; i < Histogram::c_bucketsCount; ++i )
+			{
+				cumulative += h.bucket( i );
+
+				writeSample( out, bucket.constData(),
+					camera + ",le=\"" + QByteArray::number( Histogram::bound( i ) ) + '"',
+					QByteArray::number( cumulative ) );
+			}
+
+			cumulative += h.bucket( Histogram::c_bucketsCount );
+
+			writeSample( out, bucket.constData(), camera + ",le=\"+Inf\"",
+				QByteArray::number( cumulative ) );
+			writeSample( out, ( QByteArray( name ) + "_sum" ).constData(), camera,
+				QByteArray::number( (double) h.sum() / 1000000.0, 'g', 9 ) );
+			writeSample( out, ( QByteArray( name ) + "_count" ).constData(), camera,
+				QByteArray::number( cumulative ) );
+		}
+	};
+
+	counter( "securitycam_frames_delivered_total",
+		"Frames delivered by the camera.", &CameraMetrics::m_deliveredFrames );
+	counter( "securitycam_frames_analysed_total",
+		"Frames analysed by the motion detector.", &CameraMetrics::m_analysedFrames );
+	counter( "securitycam_frames_unmapped_total",
+		"Frames that could not be mapped to memory.", &CameraMetrics::m_unmappedFrames );
+	counter( "securitycam_frames_dropped_total",
+		"Frames of the camera skipped by the pipeline.", &CameraMetrics::m_droppedFrames );
+	counter( "securitycam_preview_frames_dropped_total",
+		"Frames replaced in preview before they were scaled.",
+		&CameraMetrics::m_previewDropped );
+	gauge( "securitycam_delivered_fps",
+		"Frames delivered during the last second.", &CameraMetrics::m_deliveredFps );
+	gauge( "securitycam_analysed_fps",
+		"Frames analysed during the last second.", &CameraMetrics::m_analysedFps );
+	counter( "securitycam_motion_events_total",
+		"Detected motion events.", &CameraMetrics::m_motionEvents );
+	counter( "securitycam_lighting_changes_total",
+		"Changes of lighting of the scene.", &CameraMetrics::m_lightingChanges );
+	counter( "securitycam_tamper_events_total",
+		"Detected tampers of the camera.", &CameraMetrics::m_tamperEvents );
+	gauge( "securitycam_capture_queue_depth",
+		"Images waiting to be captured and written.", &CameraMetrics::m_captureQueue );
+	counter( "securitycam_images_written_total",
+		"Images written to disk.", &CameraMetrics::m_imagesWritten );
+	counter( "securitycam_bytes_written_total",
+		"Bytes written to disk.", &CameraMetrics::m_bytesWritten );
+	counter( "securitycam_images_suppressed_total",
+		"Images not written as near duplicates of the previous one.",
+		&CameraMetrics::m_imagesSuppressed );
+	counter( "securitycam_retention_runs_total",
+		"Runs of removing of old images.", &CameraMetrics::m_retentionRuns );
+	counter( "securitycam_retention_removed_total",
+		"Directories removed by retention.", &CameraMetrics::m_retentionRemoved );
+	counter( "securitycam_format_switches_total",
+		"Switches between full and idle formats.", &CameraMetrics::m_formatSwitches );
+	gauge( "securitycam_idle",
+		"Camera runs in idle format.", &CameraMetrics::m_idle );
+	counter( "securitycam_camera_outages_total",
+		"Outages of the camera without frames.", &CameraMetrics::m_outages );
+
+	writeHeader( out, "securitycam_camera_outage_seconds_total", "counter",
+		"Time without frames during outages." );
+
+	for( const auto & c : qAsConst( cameras ) )
+		writeSample( out, "securitycam_camera_outage_seconds_total",
+			"camera=\"" + escapeLabel( c->camera() ) + '"',
+			QByteArray::number( (double) c->m_outageMsecs.load(
+				std::memory_order_relaxed ) / 1000.0, 'f', 3 ) );
+
+	histogram( "securitycam_detection_seconds",
+		"Time spent in motion detection.", &CameraMetrics::m_detectTime );
+	histogram( "securitycam_encode_seconds",
+		"Time spent in JPEG encoding.", &CameraMetrics::m_encodeTime );
+	histogram( "securitycam_write_seconds",
+		"Time spent in writing of images.", &CameraMetrics::m_writeTime );
+	histogram( "securitycam_format_switch_seconds",
+		"Time from format switch to the first frame.", &CameraMetrics::m_switchTime );
+
+	writeHeader( out, "securitycam_kernel_info", "gauge",
+		"Instruction set chosen for the image kernel." );
+
+	for( const auto & k : Kernels::instance().selected() )
+		writeSample( out, "securitycam_kernel_info",
+			"kernel=\"" + k.first.toLatin1() + "\",isa=\"" +
+				isaName( k.second ).toLatin1() + '"', "1" );
+
+	return out;
+}
+
+
+//
+// MetricsServer
+//
+
+//! Time in milliseconds for the whole exchange with the client.
+static const int c_connectionTimeout = 5000;
+
+//! Maximum length of the request line.
+static const qint64 c_maxRequestLine = 4096;
+
+MetricsServer::MetricsServer( QObject * parent )
+	:	QObject( parent )
+	,	m_server( new QTcpServer( this ) )
+{
+	connect( m_server, &QTcpServer::newConnection,
+		this, &MetricsServer::newConnection );
+}
+
+MetricsServer::~MetricsServer()
+{
+	m_server->close();
+}
+
+void
+MetricsServer::listen( const QHostAddress & address, quint16 port )
+{
+	m_server->close();
+
+	if( port > 0 )
+	{
+		if( !m_server->listen( address, port ) )
+			qWarning( "Unable to listen for metrics on %s:%d: %s",
+				qPrintable( address.toString() ), port,
+				qPrintable( m_server->errorString() ) );
+	}
+}
+
+void
+MetricsServer::close()
+{
+	m_server->close();
+}
+
+void
+MetricsServer::newConnection()
+{
+	while( m_server->hasPendingConnections() )
+	{
+		QTcpSocket * socket = m_server->nextPendingConnection();
+
+		connect( socket, &QTcpSocket::disconnected,
+			socket, &QObject::deleteLater );
+
+		// Idle and half-open connections are closed, so they don't pile up.
+		QTimer::singleShot( c_connectionTimeout, socket,
+			[socket] ()
+			{
+				socket->abort();
+				socket->deleteLater();
+			} );
+
+		connect( socket, &QTcpSocket::readyRead, socket,
+			[socket] ()
+			{
+				if( !socket->canReadLine() )
+				{
+					if( socket->bytesAvailable() > c_maxRequestLine )
+					{
+						socket->abort();
+						socket->deleteLater();
+					}
+
+					return;
+				}
+
+				QObject::disconnect( socket, &QTcpSocket::readyRead,
+					nullptr, nullptr );
+
+				const QList< QByteArray > request =
+					socket->readLine().trimmed().split( ' ' );
+
+				QByteArray status = "200 OK";
+				QByteArray body;
+
+				if( request.size() >= 2 && request.at( 0 ) == "GET" &&
+					( request.at( 1 ) == "/metrics" || request.at( 1 ) == "/" ) )
+						body = Metrics::instance().exposition();
+				else
+				{
+					status = "404 Not Found";
+					body = "Not found.\n";
+				}
+
+				socket->write( "HTTP/1.0 " + status + "\r\n"
+					"Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+					"Content-Length: " + QByteArray::number( body.size() ) + "\r\n"
+					"Connection: close\r\n\r\n" + body );
+
+				socket->disconnectFromHost();
+			} );
+	}
+}
+
+} /* namespace SecurityCam */
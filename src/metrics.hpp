@@ -0,0 +1,197 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef SECURITYCAM_METRICS_HPP_INCLUDED
+#define SECURITYCAM_METRICS_HPP_INCLUDED
+
+// Qt include.
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+#include <QList>
+#include <QHostAddress>
+
+// C++ include.
+#include <atomic>
+#include <array>
+
+QT_BEGIN_NAMESPACE
+class QTcpServer;
+QT_END_NAMESPACE
+
+
+namespace SecurityCam {
+
+//
+// Histogram
+//
+
+//! Histogram of durations with fixed buckets, lock-free.
+class Histogram final {
+public:
+	//! Count of buckets without +Inf.
+	static const int c_bucketsCount = 12;
+
+	Histogram();
+
+	//! Observe duration in microseconds.
+	void observe( qint64 usecs );
+
+	//! \return Upper bound of the bucket in seconds.
+	static double bound( int bucket );
+
+	//! \return Count of observations in the bucket (not cumulative).
+	quint64 bucket( int i ) const;
+	//! \return Count of observations.
+	quint64 count() const;
+	//! \return Sum of observations in microseconds.
+	quint64 sum() const;
+
+private:
+	Q_DISABLE_COPY( Histogram )
+
+	//! Buckets, the last one is +Inf.
+	std::array< std::atomic< quint64 >, c_bucketsCount + 1 > m_buckets;
+	//! Count.
+	std::atomic< quint64 > m_count;
+	//! Sum.
+	std::atomic< quint64 > m_sum;
+}; // class Histogram
+
+
+//
+// CameraMetrics
+//
+
+//! Pipeline counters of one camera. Written by the pipeline, read by scraper.
+class CameraMetrics final {
+public:
+	explicit CameraMetrics( const QString & camera );
+
+	//! \return Camera's name.
+	const QString & camera() const;
+
+	//! Frames delivered by the camera.
+	std::atomic< quint64 > m_deliveredFrames;
+	//! Frames analysed by the detector.
+	std::atomic< quint64 > m_analysedFrames;
+	//! Frames that couldn't be mapped to memory.
+	std::atomic< quint64 > m_unmappedFrames;
+	//! Frames of the camera skipped by the pipeline.
+	std::atomic< quint64 > m_droppedFrames;
+	//! Frames replaced in preview before they were scaled.
+	std::atomic< quint64 > m_previewDropped;
+	//! Delivered FPS during last second.
+	std::atomic< int > m_deliveredFps;
+	//! Analysed FPS during last second.
+	std::atomic< int > m_analysedFps;
+	//! Count of motion events.
+	std::atomic< quint64 > m_motionEvents;
+	//! Count of changes of lighting of the scene.
+	std::atomic< quint64 > m_lightingChanges;
+	//! Count of detected tampers of the camera.
+	std::atomic< quint64 > m_tamperEvents;
+	//! Images waiting to be captured and written.
+	std::atomic< int > m_captureQueue;
+	//! Images written.
+	std::atomic< quint64 > m_imagesWritten;
+	//! Bytes written.
+	std::atomic< quint64 > m_bytesWritten;
+	//! Images not written as near duplicates of the previous one.
+	std::atomic< quint64 > m_imagesSuppressed;
+	//! Count of retention runs.
+	std::atomic< quint64 > m_retentionRuns;
+	//! Count of directories removed by retention.
+	std::atomic< quint64 > m_retentionRemoved;
+	//! Count of switches between full and idle formats.
+	std::atomic< quint64 > m_formatSwitches;
+	//! Is camera in idle format.
+	std::atomic< int > m_idle;
+	//! Count of outages of the camera.
+	std::atomic< quint64 > m_outages;
+	//! Time without frames during outages, in milliseconds.
+	std::atomic< quint64 > m_outageMsecs;
+	//! Detection time.
+	Histogram m_detectTime;
+	//! Encode time.
+	Histogram m_encodeTime;
+	//! Write time.
+	Histogram m_writeTime;
+	//! Time from format switch to the first frame.
+	Histogram m_switchTime;
+
+private:
+	Q_DISABLE_COPY( CameraMetrics )
+
+	//! Camera.
+	QString m_camera;
+}; // class CameraMetrics
+
+
+//
+// Metrics
+//
+
+//! Registry of metrics.
+class Metrics final {
+public:
+	//! \return Instance.
+	static Metrics & instance();
+
+	//! \return Metrics of the given camera, created on first request.
+	CameraMetrics * camera( const QString & name );
+
+	//! \return Metrics in Prometheus text format.
+	QByteArray exposition() const;
+
+private:
+	Metrics();
+	~Metrics();
+
+	Q_DISABLE_COPY( Metrics )
+
+	//! Mutex, guards only list of cameras.
+	mutable QMutex m_mutex;
+	//! Cameras.
+	QList< CameraMetrics* > m_cameras;
+}; // class Metrics
+
+
+//
+// MetricsServer
+//
+
+//! HTTP server with metrics. Should live in own thread.
+class MetricsServer final
+	:	public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit MetricsServer( QObject * parent = nullptr );
+	~MetricsServer() override;
+
+public slots:
+	//! Listen on the given address and port, 0 port stops listening.
+	void listen( const QHostAddress & address, quint16 port );
+	//! Stop listening.
+	void close();
+
+private slots:
+	//! New connection.
+	void newConnection();
+
+private:
+	Q_DISABLE_COPY( MetricsServer )
+
+	//! Server.
+	QTcpServer * m_server;
+}; // class MetricsServer
+
+} /* namespace SecurityCam */
+
+#endif // SECURITYCAM_METRICS_HPP_INCLUDED
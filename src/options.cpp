@@ -7,6 +7,7 @@
 // SecurityCam include.
 #include "options.hpp"
 #include "ui_options.h"
+#include "devices.hpp"
 
 // Qt include.
 #include <QGroupBox>
@@ -15,7 +16,6 @@
 #include <QLineEdit>
 #include <QStandardPaths>
 #include <QFileDialog>
-#include <QMediaDevices>
 
 
 namespace SecurityCam {
@@ -50,7 +50,7 @@ OptionsPrivate::init( const QCameraDevice & dev )
 {
 	m_ui.setupUi( q );
 
-	m_cameras = QMediaDevices::videoInputs();
+	m_cameras = Devices::instance().cameras();
 
 	if( !m_cameras.isEmpty() )
 	{
@@ -0,0 +1,135 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include "preview.hpp"
+#include "scale.hpp"
+#include "trace.hpp"
+#include "metrics.hpp"
+
+// Qt include.
+#include <QMutexLocker>
+
+
+namespace SecurityCam {
+
+//
+// Preview
+//
+
+Preview::Preview( QObject * parent )
+	:	QObject( parent )
+	,	m_ratio( 1.0 )
+	,	m_busy( false )
+	,	m_metrics( nullptr )
+{
+	m_pool.setMaxThreadCount( 1 );
+}
+
+Preview::~Preview()
+{
+	{
+		QMutexLocker lock( &m_mutex );
+
+		m_pending = QImage();
+	}
+
+	m_pool.waitForDone();
+}
+
+QSize
+Preview::size() const
+{
+	QMutexLocker lock( &m_mutex );
+
+	return m_size;
+}
+
+void
+Preview::setMetrics( CameraMetrics * m )
+{
+	QMutexLocker lock( &m_mutex );
+
+	m_metrics = m;
+}
+
+void
+Preview::setSize( const QSize & s, qreal ratio )
+{
+	QMutexLocker lock( &m_mutex );
+
+	m_size = s;
+	m_ratio = ratio;
+
+	if( m_size.isEmpty() )
+		m_pending = QImage();
+}
+
+void
+Preview::frame( const QImage & image )
+{
+	QMutexLocker lock( &m_mutex );
+
+	if( m_size.isEmpty() )
+		return;
+
+	if( !m_pending.isNull() && m_metrics )
+		++m_metrics->m_previewDropped;
+
+	m_pending = image;
+
+	if( !m_busy )
+	{
+		m_busy = true;
+
+		m_pool.start( [this] () { run(); } );
+	}
+}
+
+void
+Preview::run()
+{
+	forever
+	{
+		QImage image;
+		QSize size;
+		qreal ratio = 1.0;
+
+		{
+			QMutexLocker lock( &m_mutex );
+
+			if( m_pending.isNull() )
+			{
+				m_busy = false;
+
+				return;
+			}
+
+			image = m_pending;
+			size = m_size;
+			ratio = m_ratio;
+			m_pending = QImage();
+		}
+
+		QImage scaled;
+
+		{
+			ScopedTrace trace( "scale" );
+
+			scaled = scaleToFit( image, size );
+		}
+
+		if( !scaled.isNull() )
+		{
+			// View draws it 1:1 in device pixels.
+			scaled.setDevicePixelRatio( ratio );
+
+			emit ready( scaled );
+		}
+	}
+}
+
+} /* namespace SecurityCam */
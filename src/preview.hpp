@@ -0,0 +1,79 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef SECURITYCAM_PREVIEW_HPP_INCLUDED
+#define SECURITYCAM_PREVIEW_HPP_INCLUDED
+
+// Qt include.
+#include <QObject>
+#include <QImage>
+#include <QMutex>
+#include <QThreadPool>
+
+
+namespace SecurityCam {
+
+class CameraMetrics;
+
+//
+// Preview
+//
+
+//! Scales frames for the view in the worker thread. Only the latest frame
+//! is scaled, frames arrived while worker is busy are dropped and counted
+//! in metrics of the camera.
+class Preview final
+	:	public QObject
+{
+	Q_OBJECT
+
+signals:
+	//! Scaled frame is ready.
+	void ready( const QImage & image );
+
+public:
+	explicit Preview( QObject * parent = nullptr );
+	~Preview() override;
+
+	//! \return Size of the view.
+	QSize size() const;
+
+	//! Set metrics of the camera.
+	void setMetrics( CameraMetrics * m );
+
+public slots:
+	//! Set size of the view in device pixels and its device pixel ratio,
+	//! empty size disables preview.
+	void setSize( const QSize & s, qreal ratio );
+	//! New frame.
+	void frame( const QImage & image );
+
+private:
+	//! Scale pending frames.
+	void run();
+
+private:
+	Q_DISABLE_COPY( Preview )
+
+	//! Mutex.
+	mutable QMutex m_mutex;
+	//! Size.
+	QSize m_size;
+	//! Device pixel ratio.
+	qreal m_ratio;
+	//! Pending frame.
+	QImage m_pending;
+	//! Is worker busy.
+	bool m_busy;
+	//! Metrics.
+	CameraMetrics * m_metrics;
+	//! Worker.
+	QThreadPool m_pool;
+}; // class Preview
+
+} /* namespace SecurityCam */
+
+#endif // SECURITYCAM_PREVIEW_HPP_INCLUDED
@@ -7,11 +7,18 @@
 // Qt include.
 #include <QCamera>
 #include <QRegularExpression>
+#include <QPushButton>
+#include <QTreeWidgetItem>
+#include <QThreadPool>
+
+// C++ include.
+#include <atomic>
 
 // SecurityCam include.
 #include "resolution.hpp"
 #include "ui_resolution.h"
 #include "frames.hpp"
+#include "formatcost.hpp"
 
 
 namespace SecurityCam {
@@ -28,12 +35,18 @@ public:
 		:	m_cam( cam )
 		,	m_frames( frames )
 		,	m_settings( s )
+		,	m_cancelled( false )
 		,	q( parent )
 	{
+		m_pool.setMaxThreadCount( 1 );
 	}
 
 	//! Init.
 	void init();
+	//! Show measured cost of the format with the given index.
+	void costMeasured( int index, const FormatCost & cost );
+	//! Select the best format when all costs are measured.
+	void costsMeasured();
 
 	//! Camera.
 	QCameraDevice m_cam;
@@ -43,6 +56,12 @@ public:
 	QCameraFormat m_settings;
 	//! Ui.
 	Ui::ResolutionDialog m_ui;
+	//! Measured costs.
+	QVector< FormatCost > m_costs;
+	//! Pool where costs are measured, so GUI is not blocked.
+	QThreadPool m_pool;
+	//! Stop measuring.
+	std::atomic< bool > m_cancelled;
 	//! Parent.
 	ResolutionDialog * q;
 }; // class ResolutionDialogPrivate
@@ -68,6 +87,56 @@ ResolutionDialogPrivate::init()
 			s.pixelFormat() == m_settings.pixelFormat() )
 				m_ui.m_res->setCurrentIndex( m_ui.m_res->count() - 1 );
 	}
+
+	m_ui.m_costs->hide();
+
+	ResolutionDialog::connect( m_ui.m_auto, &QPushButton::clicked,
+		q, &ResolutionDialog::autoSelect );
+}
+
+void
+ResolutionDialogPrivate::costMeasured( int index, const FormatCost & cost )
+{
+	m_costs[ index ] = cost;
+
+	auto * item = new QTreeWidgetItem( m_ui.m_costs );
+	item->setText( 0, m_ui.m_res->itemText( index ) );
+
+	if( cost.m_supported )
+	{
+		item->setText( 1, QString::number( cost.m_mapTime, 'f', 2 ) );
+		item->setText( 2, QString::number( cost.m_convertTime, 'f', 2 ) );
+		item->setText( 3, QString::number( cost.m_detectTime, 'f', 2 ) );
+		item->setText( 4, QString::number( cost.m_cpu * 100.0, 'f', 1 ) );
+	}
+	else
+		item->setText( 1, ResolutionDialog::tr( "Unsupported" ) );
+}
+
+void
+ResolutionDialogPrivate::costsMeasured()
+{
+	for( int i = 0; i < m_ui.m_costs->columnCount(); ++i )
+		m_ui.m_costs->resizeColumnToContents( i );
+
+	const int best = chooseFormat( m_costs, m_ui.m_budget->value() / 100.0 );
+
+	if( best >= 0 )
+	{
+		auto * item = m_ui.m_costs->topLevelItem( best );
+
+		for( int i = 0; i < m_ui.m_costs->columnCount(); ++i )
+		{
+			QFont f = item->font( i );
+			f.setBold( true );
+			item->setFont( i, f );
+		}
+
+		m_ui.m_costs->setCurrentItem( item );
+		m_ui.m_res->setCurrentIndex( best );
+	}
+
+	m_ui.m_auto->setEnabled( true );
 }
 
 //
@@ -250,6 +319,32 @@ stringToPixelFormat( const QString & s )
 }
 
 
+//
+// findCameraFormat
+//
+
+QCameraFormat
+findCameraFormat( const QCameraDevice & dev, const Cfg::Resolution & r )
+{
+	if( r.width() <= 0 || r.height() <= 0 )
+		return QCameraFormat();
+
+	const QSize size( r.width(), r.height() );
+	const auto pixelFormat = stringToPixelFormat( r.format() );
+	const auto settings = dev.videoFormats();
+
+	for( const auto & s : settings )
+	{
+		if( s.resolution() == size &&
+			s.pixelFormat() == pixelFormat &&
+			qAbs( s.maxFrameRate() - r.fps() ) < 0.01 )
+				return s;
+	}
+
+	return QCameraFormat();
+}
+
+
 //
 // ResolutionDialog
 //
@@ -264,6 +359,8 @@ ResolutionDialog::ResolutionDialog( Frames * frames, QWidget * parent )
 
 ResolutionDialog::~ResolutionDialog() noexcept
 {
+	d->m_cancelled = true;
+	d->m_pool.waitForDone();
 }
 
 QCameraFormat
@@ -296,4 +393,34 @@ ResolutionDialog::settings() const
 	return settings.at( 0 );
 }
 
+void
+ResolutionDialog::autoSelect()
+{
+	const auto formats = d->m_cam.videoFormats();
+	const Detector detector = d->m_frames->detector();
+	const int detectionWidth = d->m_frames->detectionWidth();
+
+	d->m_ui.m_costs->clear();
+	d->m_ui.m_costs->show();
+	d->m_ui.m_auto->setEnabled( false );
+
+	d->m_costs = QVector< FormatCost >( formats.size() );
+
+	d->m_pool.start( [this, formats, detector, detectionWidth] ()
+		{
+			for( int i = 0; i < formats.size() && !d->m_cancelled; ++i )
+			{
+				const FormatCost cost = measureFormatCost( formats.at( i ),
+					detector, detectionWidth );
+
+				QMetaObject::invokeMethod( this,
+					[this, i, cost] () { d->costMeasured( i, cost ); },
+					Qt::QueuedConnection );
+			}
+
+			QMetaObject::invokeMethod( this, [this] () { d->costsMeasured(); },
+				Qt::QueuedConnection );
+		} );
+}
+
 } /* namespace SecurityCam */
@@ -12,6 +12,9 @@
 #include <QCameraDevice>
 #include <QScopedPointer>
 
+// SecurityCam include.
+#include "cfg.hpp"
+
 QT_BEGIN_NAMESPACE
 class QCamera;
 QT_END_NAMESPACE
@@ -39,6 +42,16 @@ QVideoFrameFormat::PixelFormat
 stringToPixelFormat( const QString & s );
 
 
+//
+// findCameraFormat
+//
+
+//! \return Format of the device that matches the configured resolution,
+//! or null format if there is no such one.
+QCameraFormat
+findCameraFormat( const QCameraDevice & dev, const Cfg::Resolution & r );
+
+
 //
 // ResolutionDialog
 //
@@ -58,6 +71,10 @@ public:
 	//! \return Selected settings.
 	QCameraFormat settings() const;
 
+private slots:
+	//! Measure cost of formats and select the best one.
+	void autoSelect();
+
 private:
 	Q_DISABLE_COPY( ResolutionDialog )
 
@@ -0,0 +1,104 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include "scale.hpp"
+#include "kernels.hpp"
+
+// C++ include.
+#include <vector>
+#include <algorithm>
+
+
+namespace SecurityCam {
+
+//
+// boxScale32
+//
+
+void
+boxScale32( const uchar * src, int srcWidth, int srcHeight, int srcStride,
+	uchar * dst, int dstWidth, int dstHeight, int dstStride )
+{
+	std::vector< int > xs( dstWidth + 1 );
+
+	for( int x = 0; x <= dstWidth; ++x )
+		xs[ x ] = (int) ( (qint64) x * srcWidth / dstWidth );
+
+	std::vector< quint32 > acc( dstWidth * 4 );
+
+	const BoxRow boxRow = Kernels::instance().boxRow();
+
+	for( int y = 0; y < dstHeight; ++y )
+	{
+		const int y0 = (int) ( (qint64) y * srcHeight / dstHeight );
+		const int y1 = qMax( y0 + 1, (int) ( (qint64) ( y + 1 ) * srcHeight / dstHeight ) );
+
+		std::fill( acc.begin(), acc.end(), 0 );
+
+		for( int sy = y0; sy < y1; ++sy )
+			boxRow( src + (qint64) sy * srcStride, xs.data(), dstWidth, acc.data() );
+
+		uchar * out = dst + (qint64) y * dstStride;
+		const quint32 * a = acc.data();
+
+		for( int x = 0; x < dstWidth; ++x, a += 4, out += 4 )
+		{
+			const quint32 count = (quint32) ( qMax( xs[ x ] + 1, xs[ x + 1 ] ) - xs[ x ] ) *
+				(quint32) ( y1 - y0 );
+			const quint32 half = count / 2;
+
+			out[ 0 ] = (uchar) ( ( a[ 0 ] + half ) / count );
+			out[ 1 ] = (uchar) ( ( a[ 1 ] + half ) / count );
+			out[ 2 ] = (uchar) ( ( a[ 2 ] + half ) / count );
+			out[ 3 ] = (uchar) ( ( a[ 3 ] + half ) / count );
+		}
+	}
+}
+
+
+//
+// scaleToFit
+//
+
+QImage
+scaleToFit( const QImage & image, const QSize & size )
+{
+	if( image.isNull() || size.isEmpty() )
+		return QImage();
+
+	return scaleToSize( image, image.size().scaled( size, Qt::KeepAspectRatio ) );
+}
+
+
+//
+// scaleToSize
+//
+
+QImage
+scaleToSize( const QImage & image, const QSize & target )
+{
+	if( image.isNull() || target.isEmpty() )
+		return QImage();
+
+	if( target == image.size() )
+		return image;
+
+	if( target.width() > image.width() || target.height() > image.height() )
+		return image.scaled( target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+
+	const QImage src = ( image.depth() == 32 ? image :
+		image.convertToFormat( QImage::Format_RGB32 ) );
+
+	QImage res( target, src.format() );
+
+	boxScale32( src.constBits(), src.width(), src.height(), src.bytesPerLine(),
+		res.bits(), res.width(), res.height(), res.bytesPerLine() );
+
+	return res;
+}
+
+} /* namespace SecurityCam */
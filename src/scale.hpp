@@ -0,0 +1,47 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef SECURITYCAM_SCALE_HPP_INCLUDED
+#define SECURITYCAM_SCALE_HPP_INCLUDED
+
+// Qt include.
+#include <QImage>
+
+
+namespace SecurityCam {
+
+//
+// boxScale32
+//
+
+//! Downscale 32-bit pixels with box filter. Destination should not be
+//! larger than source.
+void
+boxScale32( const uchar * src, int srcWidth, int srcHeight, int srcStride,
+	uchar * dst, int dstWidth, int dstHeight, int dstStride );
+
+
+//
+// scaleToFit
+//
+
+//! \return Image scaled to fit into the given size with kept aspect ratio.
+//! Downscaling is done with box filter, upscaling is bilinear.
+QImage
+scaleToFit( const QImage & image, const QSize & size );
+
+
+//
+// scaleToSize
+//
+
+//! \return Image scaled to exactly the given size, see scaleToFit().
+QImage
+scaleToSize( const QImage & image, const QSize & size );
+
+} /* namespace SecurityCam */
+
+#endif // SECURITYCAM_SCALE_HPP_INCLUDED
@@ -0,0 +1,146 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include "trace.hpp"
+
+// Qt include.
+#include <QMutexLocker>
+#include <QThread>
+#include <QFile>
+#include <QTextStream>
+#include <QCoreApplication>
+
+
+namespace SecurityCam {
+
+//
+// Tracer
+//
+
+std::atomic< bool > Tracer::s_enabled( false );
+
+Tracer::Tracer()
+	:	m_next( 0 )
+	,	m_full( false )
+{
+	m_clock.start();
+}
+
+Tracer &
+Tracer::instance()
+{
+	static Tracer tracer;
+
+	return tracer;
+}
+
+void
+Tracer::setEnabled( bool on )
+{
+	if( on )
+	{
+		QMutexLocker lock( &m_mutex );
+
+		if( m_events.isEmpty() )
+			m_events.resize( c_capacity );
+	}
+
+	s_enabled.store( on, std::memory_order_relaxed );
+}
+
+qint64
+Tracer::now() const
+{
+	return m_clock.nsecsElapsed();
+}
+
+void
+Tracer::add( const char * name, qint64 start, qint64 duration, qint64 id )
+{
+	QMutexLocker lock( &m_mutex );
+
+	if( m_events.isEmpty() )
+		return;
+
+	TraceEvent & e = m_events[ m_next ];
+	e.m_name = name;
+	e.m_start = start;
+	e.m_duration = duration;
+	e.m_id = id;
+	e.m_thread = reinterpret_cast< quint64 > ( QThread::currentThreadId() );
+
+	++m_next;
+
+	if( m_next == c_capacity )
+	{
+		m_next = 0;
+		m_full = true;
+	}
+}
+
+void
+Tracer::clear()
+{
+	QMutexLocker lock( &m_mutex );
+
+	m_next = 0;
+	m_full = false;
+}
+
+bool
+Tracer::dump( const QString & fileName ) const
+{
+	QVector< TraceEvent > events;
+
+	{
+		QMutexLocker lock( &m_mutex );
+
+		if( m_full )
+			events = m_events.mid( m_next ) + m_events.mid( 0, m_next );
+		else
+			events = m_events.mid( 0, m_next );
+	}
+
+	QFile file( fileName );
+
+	if( !file.open( QIODevice::WriteOnly | QIODevice::Text ) )
+		return false;
+
+	QTextStream stream( &file );
+
+	const qint64 pid = QCoreApplication::applicationPid();
+
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool first = true;
+
+	for( const auto & e : qAsConst( events ) )
+	{
+		if( !first )
+			stream << ",";
+
+		first = false;
+
+		stream << "\n{\"name\":\"" << e.m_name
+			<< "\",\"cat\":\"pipeline\",\"ph\":\"X\",\"ts\":"
+			<< QString::number( (double) e.m_start / 1000.0, 'f', 3 )
+			<< ",\"dur\":"
+			<< QString::number( (double) e.m_duration / 1000.0, 'f', 3 )
+			<< ",\"pid\":" << pid << ",\"tid\":" << e.m_thread;
+
+		if( e.m_id >= 0 )
+			stream << ",\"args\":{\"id\":" << e.m_id << "}";
+
+		stream << "}";
+	}
+
+	stream << "\n]}\n";
+
+	return true;
+}
+
+} /* namespace SecurityCam */
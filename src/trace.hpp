@@ -0,0 +1,130 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef SECURITYCAM_TRACE_HPP_INCLUDED
+#define SECURITYCAM_TRACE_HPP_INCLUDED
+
+// Qt include.
+#include <QString>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QVector>
+
+// C++ include.
+#include <atomic>
+
+
+namespace SecurityCam {
+
+//
+// TraceEvent
+//
+
+//! Complete trace event.
+struct TraceEvent {
+	//! Name of the stage.
+	const char * m_name;
+	//! Start in nanoseconds.
+	qint64 m_start;
+	//! Duration in nanoseconds.
+	qint64 m_duration;
+	//! Id of the frame or image, -1 if none.
+	qint64 m_id;
+	//! Thread.
+	quint64 m_thread;
+}; // struct TraceEvent
+
+
+//
+// Tracer
+//
+
+//! Ring buffer of trace events of the pipeline.
+class Tracer final {
+public:
+	//! Capacity of the ring buffer.
+	static const int c_capacity = 64 * 1024;
+
+	//! \return Instance.
+	static Tracer & instance();
+
+	//! \return Is tracing enabled.
+	static bool isEnabled()
+	{
+		return s_enabled.load( std::memory_order_relaxed );
+	}
+
+	//! Enable or disable tracing.
+	void setEnabled( bool on );
+
+	//! \return Time in nanoseconds since start of the application.
+	qint64 now() const;
+
+	//! Add event.
+	void add( const char * name, qint64 start, qint64 duration, qint64 id = -1 );
+
+	//! Clear collected events.
+	void clear();
+
+	//! Save collected events in Chrome trace event format,
+	//! that is supported by Perfetto too.
+	bool dump( const QString & fileName ) const;
+
+private:
+	Tracer();
+
+	Q_DISABLE_COPY( Tracer )
+
+	//! Enabled.
+	static std::atomic< bool > s_enabled;
+	//! Clock.
+	QElapsedTimer m_clock;
+	//! Mutex.
+	mutable QMutex m_mutex;
+	//! Events.
+	QVector< TraceEvent > m_events;
+	//! Position of the next event.
+	int m_next;
+	//! Is ring buffer full.
+	bool m_full;
+}; // class Tracer
+
+
+//
+// ScopedTrace
+//
+
+//! Adds event with duration of the scope if tracing is enabled.
+class ScopedTrace final {
+public:
+	explicit ScopedTrace( const char * name, qint64 id = -1 )
+		:	m_name( name )
+		,	m_id( id )
+		,	m_start( Tracer::isEnabled() ? Tracer::instance().now() : -1 )
+	{
+	}
+
+	~ScopedTrace()
+	{
+		if( m_start >= 0 )
+			Tracer::instance().add( m_name, m_start,
+				Tracer::instance().now() - m_start, m_id );
+	}
+
+private:
+	Q_DISABLE_COPY( ScopedTrace )
+
+	//! Name.
+	const char * m_name;
+	//! Id.
+	qint64 m_id;
+	//! Start.
+	qint64 m_start;
+}; // class ScopedTrace
+
+} /* namespace SecurityCam */
+
+#endif // SECURITYCAM_TRACE_HPP_INCLUDED
@@ -10,6 +10,8 @@
 // Qt include.
 #include <QPainter>
 #include <QResizeEvent>
+#include <QShowEvent>
+#include <QHideEvent>
 
 
 namespace SecurityCam {
@@ -21,19 +23,48 @@ namespace SecurityCam {
 class ViewPrivate {
 public:
 	explicit ViewPrivate( View * parent )
-		:	m_resized( false )
+		:	m_highlighted( false )
+		,	m_overlayEnabled( false )
 		,	q( parent )
 	{
 	}
 
+	//! Draw overlay in the given rectangle of the image.
+	void drawOverlay( QPainter & p, const QRect & r );
+
 	//! Image.
 	QImage m_image;
-	//! Resized?
-	bool m_resized;
+	//! Highlighted.
+	bool m_highlighted;
+	//! Overlay enabled.
+	bool m_overlayEnabled;
+	//! Overlay, one pixel per cell of the map of motion.
+	QImage m_overlay;
+	//! Bounding boxes of motion, in cells.
+	QVector< QRect > m_boxes;
 	//! Parent.
 	View * q;
 }; // class ViewPrivate
 
+void
+ViewPrivate::drawOverlay( QPainter & p, const QRect & r )
+{
+	if( !m_overlayEnabled || m_overlay.isNull() )
+		return;
+
+	p.drawImage( r, m_overlay );
+
+	const qreal sx = (qreal) r.width() / (qreal) m_overlay.width();
+	const qreal sy = (qreal) r.height() / (qreal) m_overlay.height();
+
+	p.setPen( QPen( Qt::red, 2 ) );
+	p.setBrush( Qt::NoBrush );
+
+	for( const auto & b : qAsConst( m_boxes ) )
+		p.drawRect( QRectF( r.x() + b.x() * sx, r.y() + b.y() * sy,
+			b.width() * sx, b.height() * sy ) );
+}
+
 
 //
 // View
@@ -50,10 +81,45 @@ View::~View() noexcept
 }
 
 void
-View::draw( const QImage & image )
+View::setHighlighted( bool on )
 {
-	d->m_resized = false;
+	if( d->m_highlighted != on )
+	{
+		d->m_highlighted = on;
 
+		update();
+	}
+}
+
+void
+View::setOverlayEnabled( bool on )
+{
+	d->m_overlayEnabled = on;
+
+	if( !on )
+	{
+		d->m_overlay = QImage();
+		d->m_boxes.clear();
+	}
+
+	update();
+}
+
+void
+View::setMotionMap( const MotionMap & map )
+{
+	if( d->m_overlayEnabled && isVisible() )
+	{
+		d->m_overlay = map.overlay();
+		d->m_boxes = map.boxes();
+
+		update();
+	}
+}
+
+void
+View::draw( const QImage & image )
+{
 	d->m_image = image;
 
 	update();
@@ -68,17 +134,31 @@ View::paintEvent( QPaintEvent * )
 
 		if( !d->m_image.isNull() )
 		{
-			if( !d->m_resized )
-			{
-				d->m_image = d->m_image.scaled( size(), Qt::KeepAspectRatio );
+			// Preview is scaled in device pixels, it's scaled here only
+			// while the view is resized.
+			const QSize imageSize = d->m_image.deviceIndependentSize().toSize();
+
+			const QSize s = ( imageSize.width() > width() ||
+				imageSize.height() > height() ?
+					imageSize.scaled( size(), Qt::KeepAspectRatio ) :
+					imageSize );
 
-				d->m_resized = true;
-			}
+			const int x = rect().x() + ( size().width() - s.width() ) / 2;
+			const int y = rect().y() + ( size().height() - s.height() ) / 2;
 
-			const int x = rect().x() + ( size().width() - d->m_image.width() ) / 2;
-			const int y = rect().y() + ( size().height() - d->m_image.height() ) / 2;
+			if( s == imageSize )
+				p.drawImage( x, y, d->m_image );
+			else
+				p.drawImage( QRect( QPoint( x, y ), s ), d->m_image );
 
-			p.drawImage( x, y, d->m_image );
+			d->drawOverlay( p, QRect( QPoint( x, y ), s ) );
+		}
+
+		if( d->m_highlighted )
+		{
+			p.setPen( QPen( palette().color( QPalette::Highlight ), 2 ) );
+			p.setBrush( Qt::NoBrush );
+			p.drawRect( rect().adjusted( 1, 1, -1, -1 ) );
 		}
 	}
 }
@@ -88,9 +168,28 @@ View::resizeEvent( QResizeEvent * e )
 {
 	e->accept();
 
-	d->m_resized = false;
+	if( isVisible() )
+		emit previewSizeChanged( e->size() );
 
 	update();
 }
 
+void
+View::showEvent( QShowEvent * e )
+{
+	QWidget::showEvent( e );
+
+	emit previewSizeChanged( size() );
+}
+
+void
+View::hideEvent( QHideEvent * e )
+{
+	QWidget::hideEvent( e );
+
+	d->m_image = QImage();
+
+	emit previewSizeChanged( QSize() );
+}
+
 } /* namespace SecurityCam */
@@ -11,6 +11,9 @@
 #include <QWidget>
 #include <QScopedPointer>
 
+// SecurityCam include.
+#include "detector.hpp"
+
 
 namespace SecurityCam {
 
@@ -26,17 +29,31 @@ class View final
 {
 	Q_OBJECT
 
+signals:
+	//! Size of the preview changed, empty size if view is not visible.
+	void previewSizeChanged( const QSize & s );
+
 public:
 	explicit View( QWidget * parent );
 	~View() noexcept override;
 
+	//! Set highlighted.
+	void setHighlighted( bool on );
+
+	//! Enable or disable overlay with motion.
+	void setOverlayEnabled( bool on );
+
 public slots:
-	//! Draw image.
+	//! Draw image, scaled to the size of the view.
 	void draw( const QImage & image );
+	//! Set map of motion to be drawn over the image.
+	void setMotionMap( const SecurityCam::MotionMap & map );
 
 protected:
 	void paintEvent( QPaintEvent * ) override;
 	void resizeEvent( QResizeEvent * e ) override;
+	void showEvent( QShowEvent * e ) override;
+	void hideEvent( QHideEvent * e ) override;
 
 private:
 	Q_DISABLE_COPY( View )
@@ -0,0 +1,154 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include <calibration.hpp>
+
+// Qt include.
+#include <QTextStream>
+
+// C++ include.
+#include <initializer_list>
+
+
+using SecurityCam::Calibration;
+
+//! Night luma of tests.
+static const qreal c_nightLuma = 0.25;
+
+//! Luma far below night luma.
+static const qreal c_dark = c_nightLuma - 2.0 * Calibration::c_profileBand;
+
+//! Luma far above night luma.
+static const qreal c_light = c_nightLuma + 2.0 * Calibration::c_profileBand;
+
+
+//! \return Calibration with night luma of tests.
+static Calibration
+calibration()
+{
+	Calibration c;
+	c.setRules( 0.99, 0.005, c_nightLuma );
+
+	return c;
+}
+
+//! Feed the luma the given count of times. \return Is profile kept.
+static bool
+feed( Calibration & c, qreal luma, int count )
+{
+	const auto profile = c.currentProfile();
+
+	for( int i = 0; i < count; ++i )
+	{
+		if( c.updateProfile( luma ) != profile )
+			return false;
+	}
+
+	return true;
+}
+
+//! Luma around night luma within the band never changes profile.
+static bool
+testBand()
+{
+	Calibration c = calibration();
+
+	for( int i = 0; i < 100; ++i )
+	{
+		for( const qreal d : { -0.9, -0.5, 0.0, 0.5, 0.9 } )
+		{
+			if( c.updateProfile( c_nightLuma + d * Calibration::c_profileBand ) !=
+				Calibration::Day )
+					return false;
+		}
+	}
+
+	return true;
+}
+
+//! Flickering light far on both sides of night luma doesn't change profile
+//! while there are less confirmations in a row than needed.
+static bool
+testFlicker()
+{
+	Calibration c = calibration();
+
+	for( int i = 0; i < 100; ++i )
+	{
+		if( !feed( c, c_dark, Calibration::c_profileConfirmations - 1 ) )
+			return false;
+
+		if( !feed( c, c_light, 1 ) )
+			return false;
+	}
+
+	return ( c.currentProfile() == Calibration::Day );
+}
+
+//! Lasting change switches profile exactly on the last confirmation, both
+//! ways.
+static bool
+testSwitch()
+{
+	Calibration c = calibration();
+
+	if( !feed( c, c_dark, Calibration::c_profileConfirmations - 1 ) )
+		return false;
+
+	if( c.updateProfile( c_dark ) != Calibration::Night )
+		return false;
+
+	// Band keeps night too.
+	if( !feed( c, c_nightLuma + 0.5 * Calibration::c_profileBand, 100 ) )
+		return false;
+
+	if( !feed( c, c_light, Calibration::c_profileConfirmations - 1 ) )
+		return false;
+
+	return ( c.updateProfile( c_light ) == Calibration::Day );
+}
+
+//! Frame in the band breaks the row of confirmations.
+static bool
+testBreak()
+{
+	Calibration c = calibration();
+
+	if( !feed( c, c_dark, Calibration::c_profileConfirmations - 1 ) )
+		return false;
+
+	if( !feed( c, c_nightLuma, 1 ) )
+		return false;
+
+	if( !feed( c, c_dark, Calibration::c_profileConfirmations - 1 ) )
+		return false;
+
+	return ( c.updateProfile( c_dark ) == Calibration::Night );
+}
+
+
+int main()
+{
+	QTextStream out( stdout );
+
+	bool failed = false;
+
+	const auto check = [&out, &failed] ( const char * name, bool ok )
+	{
+		out << name << ": " << ( ok ? "passed" : "FAILED" ) << "\n";
+
+		if( !ok )
+			failed = true;
+	};
+
+	check( "band", testBand() );
+	check( "flicker", testFlicker() );
+	check( "switch", testSwitch() );
+	check( "break", testBreak() );
+
+	return ( failed ? 1 : 0 );
+}
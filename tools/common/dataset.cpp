@@ -0,0 +1,117 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include "dataset.hpp"
+
+// Qt include.
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+
+
+static const QString c_labels = QStringLiteral( "labels.txt" );
+
+static const QString c_settings = QStringLiteral( "settings.txt" );
+
+
+//! Read settings of the sequence, file is optional.
+static void
+readSettings( const QDir & dir, Sequence & seq )
+{
+	QFile file( dir.filePath( c_settings ) );
+
+	if( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+		return;
+
+	QTextStream stream( &file );
+
+	while( !stream.atEnd() )
+	{
+		const QString line = stream.readLine().trimmed();
+
+		if( line.isEmpty() || line.startsWith( QLatin1Char( '#' ) ) )
+			continue;
+
+		const QStringList parts = line.split( QLatin1Char( ' ' ), Qt::SkipEmptyParts );
+
+		if( parts.size() == 2 )
+			seq.m_settings.insert( parts.at( 0 ), parts.at( 1 ).toDouble() );
+	}
+}
+
+
+//
+// readSequence
+//
+
+bool
+readSequence( const QDir & dir, Sequence & seq )
+{
+	QFile file( dir.filePath( c_labels ) );
+
+	if( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+		return false;
+
+	seq.m_name = dir.dirName();
+
+	QTextStream stream( &file );
+
+	while( !stream.atEnd() )
+	{
+		const QString line = stream.readLine().trimmed();
+
+		if( line.isEmpty() || line.startsWith( QLatin1Char( '#' ) ) )
+			continue;
+
+		const QStringList parts = line.split( QLatin1Char( ' ' ), Qt::SkipEmptyParts );
+
+		if( parts.size() != 2 )
+			continue;
+
+		Sample s;
+		s.m_fileName = dir.filePath( parts.at( 0 ) );
+		s.m_motion = ( parts.at( 1 ).toInt() != 0 );
+
+		seq.m_samples.append( s );
+	}
+
+	readSettings( dir, seq );
+
+	return !seq.m_samples.isEmpty();
+}
+
+
+//
+// readDataSet
+//
+
+QVector< Sequence >
+readDataSet( const QString & path )
+{
+	QVector< Sequence > res;
+
+	QDir root( path );
+
+	Sequence seq;
+
+	if( readSequence( root, seq ) )
+		res.append( seq );
+
+	const auto dirs = root.entryList( QDir::Dirs | QDir::NoDotAndDotDot,
+		QDir::Name );
+
+	for( const auto & d : dirs )
+	{
+		Sequence seq;
+
+		if( readSequence( QDir( root.filePath( d ) ), seq ) )
+			res.append( seq );
+	}
+
+	return res;
+}
@@ -0,0 +1,142 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef SECURITYCAM_TOOLS_DATASET_HPP_INCLUDED
+#define SECURITYCAM_TOOLS_DATASET_HPP_INCLUDED
+
+// Qt include.
+#include <QString>
+#include <QVector>
+#include <QMap>
+
+QT_BEGIN_NAMESPACE
+class QDir;
+QT_END_NAMESPACE
+
+
+//
+// Sample
+//
+
+//! Labelled frame of the sequence.
+struct Sample {
+	//! File name.
+	QString m_fileName;
+	//! Is motion on this frame.
+	bool m_motion;
+}; // struct Sample
+
+
+//
+// Sequence
+//
+
+//! Labelled sequence.
+struct Sequence {
+	//! Name.
+	QString m_name;
+	//! Frames.
+	QVector< Sample > m_samples;
+	//! Settings of the detector from settings.txt, by names of the
+	//! configuration file, e.g. blobThreshold.
+	QMap< QString, qreal > m_settings;
+}; // struct Sequence
+
+
+//
+// Result
+//
+
+//! Result of the detection.
+struct Result {
+	Result()
+		:	m_tp( 0 )
+		,	m_fp( 0 )
+		,	m_fn( 0 )
+		,	m_tn( 0 )
+		,	m_frames( 0 )
+		,	m_nsecs( 0 )
+	{
+	}
+
+	//! \return Precision.
+	qreal precision() const
+	{
+		return ( m_tp + m_fp > 0 ? (qreal) m_tp / (qreal) ( m_tp + m_fp ) : 1.0 );
+	}
+
+	//! \return Recall.
+	qreal recall() const
+	{
+		return ( m_tp + m_fn > 0 ? (qreal) m_tp / (qreal) ( m_tp + m_fn ) : 1.0 );
+	}
+
+	//! \return Cost of one frame in microseconds.
+	qreal cost() const
+	{
+		return ( m_frames > 0 ? (qreal) m_nsecs / (qreal) m_frames / 1000.0 : 0.0 );
+	}
+
+	//! Add another result.
+	void add( const Result & other )
+	{
+		m_tp += other.m_tp;
+		m_fp += other.m_fp;
+		m_fn += other.m_fn;
+		m_tn += other.m_tn;
+		m_frames += other.m_frames;
+		m_nsecs += other.m_nsecs;
+	}
+
+	//! Count the frame with the given detection and label.
+	void count( bool detected, bool motion )
+	{
+		if( detected && motion )
+			++m_tp;
+		else if( detected && !motion )
+			++m_fp;
+		else if( !detected && motion )
+			++m_fn;
+		else
+			++m_tn;
+	}
+
+	//! True positives.
+	qint64 m_tp;
+	//! False positives.
+	qint64 m_fp;
+	//! False negatives.
+	qint64 m_fn;
+	//! True negatives.
+	qint64 m_tn;
+	//! Count of processed frames.
+	qint64 m_frames;
+	//! Time spent in processing of frames.
+	qint64 m_nsecs;
+}; // struct Result
+
+
+//
+// readSequence
+//
+
+//! Read sequence labelled in labels.txt of the given directory, with
+//! optional settings.txt of "name value" lines.
+//! \return Is there at least one labelled frame.
+bool
+readSequence( const QDir & dir, Sequence & seq );
+
+
+//
+// readDataSet
+//
+
+//! \return All sequences of the data set, the root directory and its
+//! subdirectories are read.
+QVector< Sequence >
+readDataSet( const QString & path );
+
+#endif // SECURITYCAM_TOOLS_DATASET_HPP_INCLUDED
@@ -0,0 +1,395 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include <detector.hpp>
+#include <kernels.hpp>
+#include <scale.hpp>
+#include <dataset.hpp>
+
+// Qt include.
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QMap>
+
+// Args include.
+#include <args-parser/all.hpp>
+
+
+//! Interval between frames of golden sequences, in milliseconds.
+static const qint64 c_frameInterval = 100;
+
+//! Count of timed runs of every sequence, the fastest one is taken.
+static const int c_runs = 20;
+
+//! Result of the reference workload, so it's not optimized out.
+static volatile qreal s_referenceSum = 0.0;
+
+//! Reference workload on the pair of frames: squared difference of channels
+//! in a plain loop. It doesn't depend on the detector and its kernels, so
+//! cost relative to it doesn't depend on speed of the machine.
+static void
+referenceWork( const QImage & key, const QImage & image )
+{
+	qreal sum = 0.0;
+
+	for( int y = 0; y < key.height(); ++y )
+	{
+		const uchar * l1 = key.constScanLine( y );
+		const uchar * l2 = image.constScanLine( y );
+
+		for( int x = 0; x < key.width() * 4; ++x )
+		{
+			const int d = (int) l1[ x ] - (int) l2[ x ];
+
+			sum += d * d;
+		}
+	}
+
+	s_referenceSum = s_referenceSum + sum;
+}
+
+//! Read frames of the sequence. \return Are all frames read.
+static bool
+readFrames( const Sequence & seq, QVector< QImage > & frames, QTextStream & out )
+{
+	for( const auto & s : seq.m_samples )
+	{
+		const QImage frame( s.m_fileName );
+
+		if( frame.isNull() )
+		{
+			out << "Unable to read frame \"" << s.m_fileName << "\".\n";
+
+			return false;
+		}
+
+		frames.append( frame.convertToFormat( QImage::Format_RGB32 ) );
+	}
+
+	return true;
+}
+
+//! Run detector with settings of the sequence on its frames. Time of
+//! scaling to the detection width and of the detector is in the result,
+//! time of the reference workload on the same frames is in reference.
+static void
+runSequence( const Sequence & seq, const QVector< QImage > & frames,
+	qreal threshold, Result & res, qint64 & reference )
+{
+	const auto & settings = seq.m_settings;
+	const int width = (int) settings.value( QStringLiteral( "detectionWidth" ), 0.0 );
+
+	QElapsedTimer timer;
+
+	for( int run = 0; run < c_runs; ++run )
+	{
+		SecurityCam::Detector detector(
+			settings.value( QStringLiteral( "threshold" ), threshold ) );
+		detector.setOffThreshold(
+			settings.value( QStringLiteral( "offThreshold" ), 0.0 ) );
+		detector.setBlobRules(
+			settings.value( QStringLiteral( "blobThreshold" ), 0.0 ),
+			settings.value( QStringLiteral( "minBlobArea" ), 0.001 ),
+			(int) settings.value( QStringLiteral( "minBlobCount" ), 1.0 ) );
+		detector.setHysteresis(
+			(int) settings.value( QStringLiteral( "motionConfirmations" ), 1.0 ),
+			(int) settings.value( QStringLiteral( "motionWindow" ), 1.0 ),
+			(qint64) settings.value( QStringLiteral( "minEventDuration" ), 0.0 ) );
+
+		Result r;
+
+		for( int i = 0; i < frames.size(); ++i )
+		{
+			const QImage & image = frames.at( i );
+
+			timer.start();
+
+			const bool detected = detector.process(
+				( width > 0 && image.width() > width ?
+					SecurityCam::scaleToSize( image, image.size().scaled(
+						QSize( width, image.height() ), Qt::KeepAspectRatio ) ) :
+					image ), i * c_frameInterval );
+
+			r.m_nsecs += timer.nsecsElapsed();
+			++r.m_frames;
+
+			// First frame has nothing to be compared with.
+			if( !detector.hasDifference() )
+				continue;
+
+			r.count( detected, seq.m_samples.at( i ).m_motion );
+		}
+
+		// Detection doesn't depend on the run, only time does.
+		if( run == 0 || r.m_nsecs < res.m_nsecs )
+			res = r;
+
+		qint64 t = 0;
+
+		for( int i = 1; i < frames.size(); ++i )
+		{
+			timer.start();
+
+			referenceWork( frames.at( i - 1 ), frames.at( i ) );
+
+			t += timer.nsecsElapsed();
+		}
+
+		if( run == 0 || t < reference )
+			reference = t;
+	}
+}
+
+//! Read baseline.
+static QMap< QString, qreal >
+readBaseline( const QString & fileName )
+{
+	QMap< QString, qreal > res;
+
+	QFile file( fileName );
+
+	if( file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+	{
+		QTextStream stream( &file );
+
+		while( !stream.atEnd() )
+		{
+			const QStringList parts = stream.readLine().trimmed()
+				.split( QLatin1Char( ' ' ), Qt::SkipEmptyParts );
+
+			if( parts.size() == 2 )
+				res.insert( parts.at( 0 ), parts.at( 1 ).toDouble() );
+		}
+	}
+
+	return res;
+}
+
+//! Write baseline, costs of other instruction sets are kept.
+static bool
+writeBaseline( const QString & fileName, QMap< QString, qreal > base,
+	const Result & r, const QString & costKey, qreal cost )
+{
+	QFile file( fileName );
+
+	if( !file.open( QIODevice::WriteOnly | QIODevice::Text ) )
+		return false;
+
+	base.insert( QStringLiteral( "precision" ), r.precision() );
+	base.insert( QStringLiteral( "recall" ), r.recall() );
+	base.insert( costKey, cost );
+
+	QTextStream stream( &file );
+
+	for( auto it = base.cbegin(), last = base.cend(); it != last; ++it )
+		stream << it.key() << " " << QString::number( it.value(), 'f', 3 ) << "\n";
+
+	return true;
+}
+
+//! Print result.
+static void
+printResult( QTextStream & out, const QString & name, const Result & r,
+	qint64 reference )
+{
+	out << name << ": frames " << r.m_frames
+		<< ", precision " << QString::number( r.precision(), 'f', 3 )
+		<< ", recall " << QString::number( r.recall(), 'f', 3 )
+		<< ", cost " << QString::number( r.cost(), 'f', 1 ) << " us/frame, "
+		<< QString::number( (qreal) r.m_nsecs / (qreal) qMax( reference, Q_INT64_C( 1 ) ), 'f', 3 )
+		<< " of reference\n";
+}
+
+
+int main( int argc, char ** argv )
+{
+	QCoreApplication app( argc, argv );
+
+	QString dataSet;
+	QString baseline;
+	qreal threshold = 0.02;
+	qreal accuracyTolerance = 0.02;
+	qreal speedTolerance = 0.25;
+	bool write = false;
+	SecurityCam::Isa isa = SecurityCam::Isa::Avx512;
+
+	try {
+		Args::CmdLine cmd;
+
+		cmd.addArgWithFlagAndName( QLatin1Char( 'd' ), QLatin1String( "data" ),
+				true, true, QLatin1String( "Directory with golden sequences." ) )
+			.addArgWithFlagAndName( QLatin1Char( 't' ), QLatin1String( "threshold" ),
+				true, false, QLatin1String( "Threshold of the detector." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'b' ), QLatin1String( "baseline" ),
+				true, false, QLatin1String( "Baseline file." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'w' ), QLatin1String( "write" ),
+				false, false, QLatin1String( "Write results to the baseline file." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'a' ), QLatin1String( "accuracy" ),
+				true, false, QLatin1String( "Allowed drop of precision and recall." ) )
+			.addArgWithFlagAndName( QLatin1Char( 's' ), QLatin1String( "speed" ),
+				true, false, QLatin1String( "Allowed relative growth of cost, "
+					"cost is relative to the reference workload." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'i' ), QLatin1String( "isa" ),
+				true, false, QLatin1String( "Limit image kernels to the given "
+					"instruction set: generic, sse2, avx2, avx512 or neon." ) )
+			.addHelp( true, argv[ 0 ],
+				QLatin1String( "Runs golden sequences through the motion detector." ) );
+
+		cmd.parse( argc, argv );
+
+		dataSet = cmd.value( QLatin1String( "-d" ) );
+
+		if( cmd.isDefined( QLatin1String( "-t" ) ) )
+			threshold = cmd.value( QLatin1String( "-t" ) ).toDouble();
+
+		if( cmd.isDefined( QLatin1String( "-b" ) ) )
+			baseline = cmd.value( QLatin1String( "-b" ) );
+		else
+			baseline = QDir( dataSet ).filePath( QStringLiteral( "baseline.txt" ) );
+
+		write = cmd.isDefined( QLatin1String( "-w" ) );
+
+		if( cmd.isDefined( QLatin1String( "-a" ) ) )
+			accuracyTolerance = cmd.value( QLatin1String( "-a" ) ).toDouble();
+
+		if( cmd.isDefined( QLatin1String( "-s" ) ) )
+			speedTolerance = cmd.value( QLatin1String( "-s" ) ).toDouble();
+
+		if( cmd.isDefined( QLatin1String( "-i" ) ) &&
+			!SecurityCam::isaFromName( cmd.value( QLatin1String( "-i" ) ), isa ) )
+		{
+			QTextStream( stderr ) << "Unknown instruction set \""
+				<< cmd.value( QLatin1String( "-i" ) ) << "\" for this build.\n";
+
+			return 1;
+		}
+	}
+	catch( const Args::HelpHasBeenPrintedException & )
+	{
+		return 0;
+	}
+	catch( const Args::BaseException & x )
+	{
+		QTextStream( stderr ) << x.desc() << "\n";
+
+		return 1;
+	}
+
+	QTextStream out( stdout );
+
+	SecurityCam::Kernels::instance().select( isa );
+
+	out << "Kernels: " << SecurityCam::Kernels::instance().description() << "\n";
+
+	const auto sequences = readDataSet( dataSet );
+
+	if( sequences.isEmpty() )
+	{
+		out << "No golden sequences in \"" << dataSet << "\".\n";
+
+		return 1;
+	}
+
+	// Cost is relative to the reference workload and is kept per instruction
+	// set of the difference kernel, where the detector spends its time.
+	SecurityCam::Isa used = SecurityCam::Isa::Generic;
+
+	for( const auto & k : SecurityCam::Kernels::instance().selected() )
+	{
+		if( k.first == QLatin1String( "difference" ) )
+			used = k.second;
+	}
+
+	const QString costKey = QStringLiteral( "cost." ) + SecurityCam::isaName( used );
+	const QString genericKey = QStringLiteral( "cost." ) +
+		SecurityCam::isaName( SecurityCam::Isa::Generic );
+
+	Result total;
+	qint64 totalReference = 0;
+
+	for( const auto & seq : sequences )
+	{
+		QVector< QImage > frames;
+
+		if( !readFrames( seq, frames, out ) )
+			return 1;
+
+		Result r;
+		qint64 reference = 0;
+
+		runSequence( seq, frames, threshold, r, reference );
+
+		printResult( out, seq.m_name, r, reference );
+
+		total.add( r );
+		totalReference += reference;
+	}
+
+	printResult( out, QStringLiteral( "Total" ), total, totalReference );
+
+	const qreal cost = (qreal) total.m_nsecs /
+		(qreal) qMax( totalReference, Q_INT64_C( 1 ) );
+
+	const auto base = readBaseline( baseline );
+
+	if( write )
+	{
+		if( !writeBaseline( baseline, base, total, costKey, cost ) )
+		{
+			out << "Unable to write baseline \"" << baseline << "\".\n";
+
+			return 1;
+		}
+
+		return 0;
+	}
+
+	if( base.isEmpty() )
+	{
+		out << "No baseline \"" << baseline << "\", write it with -w.\n";
+
+		return 1;
+	}
+
+	bool failed = false;
+
+	if( total.precision() < base.value( QStringLiteral( "precision" ) ) - accuracyTolerance )
+	{
+		out << "Precision regressed from "
+			<< base.value( QStringLiteral( "precision" ) ) << ".\n";
+		failed = true;
+	}
+
+	if( total.recall() < base.value( QStringLiteral( "recall" ) ) - accuracyTolerance )
+	{
+		out << "Recall regressed from "
+			<< base.value( QStringLiteral( "recall" ) ) << ".\n";
+		failed = true;
+	}
+
+	// Vector kernels are not slower than generic ones, so cost of generic
+	// kernels bounds instruction sets without own baseline.
+	const qreal baseCost = base.value( costKey, base.value( genericKey ) );
+
+	if( baseCost <= 0.0 )
+	{
+		out << "No " << genericKey << " in baseline, write it with -w -i generic.\n";
+		failed = true;
+	}
+	else if( cost > baseCost * ( 1.0 + speedTolerance ) )
+	{
+		out << "Cost regressed from " << baseCost << " to "
+			<< QString::number( cost, 'f', 3 ) << " of reference.\n";
+		failed = true;
+	}
+
+	return ( failed ? 1 : 0 );
+}
@@ -0,0 +1,471 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include <detector.hpp>
+#include <scale.hpp>
+
+// Qt include.
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <QDateTime>
+#include <QVector>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+
+// Args include.
+#include <args-parser/all.hpp>
+
+
+//
+// Day
+//
+
+//! Day of the archive.
+struct Day {
+	//! Date.
+	QDate m_date;
+	//! Directory.
+	QString m_path;
+}; // struct Day
+
+
+//
+// Event
+//
+
+//! Motion event found in the archive.
+struct Event {
+	Event()
+		:	m_frames( 0 )
+		,	m_peak( 0.0 )
+		,	m_sum( 0.0 )
+	{
+	}
+
+	//! \return Mean difference of the event.
+	qreal mean() const
+	{
+		return ( m_frames > 0 ? m_sum / (qreal) m_frames : 0.0 );
+	}
+
+	//! Start.
+	QDateTime m_start;
+	//! End.
+	QDateTime m_end;
+	//! First frame.
+	QString m_fileName;
+	//! Count of frames with motion.
+	int m_frames;
+	//! Maximum difference.
+	qreal m_peak;
+	//! Sum of differences.
+	qreal m_sum;
+}; // struct Event
+
+
+//
+// Options
+//
+
+//! Options of the detector.
+struct Options {
+	Options()
+		:	m_threshold( 0.02 )
+		,	m_offThreshold( 0.0 )
+		,	m_confirmations( 1 )
+		,	m_window( 1 )
+		,	m_minDuration( 0 )
+		,	m_blobThreshold( 0.0 )
+		,	m_minBlobArea( 0.001 )
+		,	m_minBlobCount( 1 )
+		,	m_lightCompensation( false )
+		,	m_lightingThreshold( 0.1 )
+		,	m_detectionWidth( 0 )
+	{
+	}
+
+	//! Threshold.
+	qreal m_threshold;
+	//! Threshold of end of motion.
+	qreal m_offThreshold;
+	//! Confirmations of motion.
+	int m_confirmations;
+	//! Window of confirmations.
+	int m_window;
+	//! Minimum duration of event in milliseconds.
+	int m_minDuration;
+	//! Threshold of difference of pixel for blobs, 0 means mean difference.
+	qreal m_blobThreshold;
+	//! Minimum area of blob, fraction of the frame.
+	qreal m_minBlobArea;
+	//! Minimum count of blobs.
+	int m_minBlobCount;
+	//! Compensate lighting.
+	bool m_lightCompensation;
+	//! Threshold of change of lighting.
+	qreal m_lightingThreshold;
+	//! Width of frames for detection, 0 means as is.
+	int m_detectionWidth;
+}; // struct Options
+
+
+//! \return Sorted numeric subdirectories with the given count of digits.
+static QStringList
+numericDirs( const QDir & dir, int digits )
+{
+	QStringList res;
+
+	const auto dirs = dir.entryList( QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name );
+
+	for( const auto & d : dirs )
+	{
+		bool ok = false;
+		d.toInt( &ok );
+
+		if( ok && d.size() == digits )
+			res.append( d );
+	}
+
+	return res;
+}
+
+//! Scan archive in yyyy/MM/dd layout.
+static QVector< Day >
+scanArchive( const QString & path )
+{
+	QVector< Day > res;
+
+	const QDir root( path );
+
+	for( const auto & y : numericDirs( root, 4 ) )
+	{
+		const QDir year( root.filePath( y ) );
+
+		for( const auto & m : numericDirs( year, 2 ) )
+		{
+			const QDir month( year.filePath( m ) );
+
+			for( const auto & d : numericDirs( month, 2 ) )
+			{
+				Day day;
+				day.m_date = QDate::fromString( y + QLatin1Char( '/' ) + m +
+					QLatin1Char( '/' ) + d, QStringLiteral( "yyyy/MM/dd" ) );
+				day.m_path = month.filePath( d );
+
+				if( day.m_date.isValid() )
+					res.append( day );
+			}
+		}
+	}
+
+	return res;
+}
+
+//! Run detector on frames of the day. Only one frame is decoded at a time.
+static QVector< Event >
+replayDay( const Day & day, const Options & opts, qint64 & frames )
+{
+	QVector< Event > res;
+
+	SecurityCam::Detector detector( opts.m_threshold );
+	detector.setOffThreshold( opts.m_offThreshold );
+	detector.setHysteresis( opts.m_confirmations, opts.m_window, opts.m_minDuration );
+	detector.setBlobRules( opts.m_blobThreshold, opts.m_minBlobArea, opts.m_minBlobCount );
+	detector.setLightCompensation( opts.m_lightCompensation, opts.m_lightingThreshold );
+
+	const QDir dir( day.m_path );
+
+	const auto files = dir.entryList( QStringList() << QStringLiteral( "*.jpg" ),
+		QDir::Files, QDir::Name );
+
+	Event e;
+	bool inEvent = false;
+
+	for( const auto & f : files )
+	{
+		const QTime time = QTime::fromString( QFileInfo( f ).completeBaseName(),
+			QStringLiteral( "hh.mm.ss" ) );
+
+		if( !time.isValid() )
+			continue;
+
+		QImage image( dir.filePath( f ) );
+
+		if( image.isNull() )
+			continue;
+
+		image = image.convertToFormat( QImage::Format_RGB32 );
+
+		if( opts.m_detectionWidth > 0 && image.width() > opts.m_detectionWidth )
+			image = SecurityCam::scaleToFit( image,
+				QSize( opts.m_detectionWidth, image.height() ) );
+
+		const bool detected = detector.process( image, time.msecsSinceStartOfDay() );
+
+		++frames;
+
+		// First frame has nothing to be compared with.
+		if( !detector.hasDifference() )
+			continue;
+
+		if( detected )
+		{
+			if( !inEvent )
+			{
+				e = Event();
+				e.m_start = QDateTime( day.m_date, time );
+				e.m_fileName = dir.filePath( f );
+				inEvent = true;
+			}
+
+			e.m_end = QDateTime( day.m_date, time );
+			e.m_peak = qMax( e.m_peak, detector.difference() );
+			e.m_sum += detector.difference();
+			++e.m_frames;
+		}
+		else if( inEvent )
+		{
+			res.append( e );
+			inEvent = false;
+		}
+	}
+
+	if( inEvent )
+		res.append( e );
+
+	return res;
+}
+
+//! Write events as CSV.
+static void
+writeCsv( QTextStream & out, const QVector< Event > & events )
+{
+	out << "start,end,frames,peak,mean,file\n";
+
+	for( const auto & e : events )
+		out << e.m_start.toString( Qt::ISODate ) << ","
+			<< e.m_end.toString( Qt::ISODate ) << ","
+			<< e.m_frames << ","
+			<< QString::number( e.m_peak, 'f', 5 ) << ","
+			<< QString::number( e.mean(), 'f', 5 ) << ",\""
+			<< QString( e.m_fileName ).replace( QLatin1Char( '"' ),
+				QStringLiteral( "\"\"" ) ) << "\"\n";
+}
+
+//! Write events as JSON.
+static void
+writeJson( QTextStream & out, const QVector< Event > & events )
+{
+	QJsonArray array;
+
+	for( const auto & e : events )
+	{
+		QJsonObject o;
+		o.insert( QStringLiteral( "start" ), e.m_start.toString( Qt::ISODate ) );
+		o.insert( QStringLiteral( "end" ), e.m_end.toString( Qt::ISODate ) );
+		o.insert( QStringLiteral( "frames" ), e.m_frames );
+		o.insert( QStringLiteral( "peak" ), e.m_peak );
+		o.insert( QStringLiteral( "mean" ), e.mean() );
+		o.insert( QStringLiteral( "file" ), e.m_fileName );
+
+		array.append( o );
+	}
+
+	out << QJsonDocument( array ).toJson( QJsonDocument::Indented );
+}
+
+
+int main( int argc, char ** argv )
+{
+	QCoreApplication app( argc, argv );
+
+	QString archive;
+	QString output;
+	QString format = QStringLiteral( "csv" );
+	int jobs = QThread::idealThreadCount();
+	Options opts;
+
+	try {
+		Args::CmdLine cmd;
+
+		cmd.addArgWithFlagAndName( QLatin1Char( 'd' ), QLatin1String( "archive" ),
+				true, true, QLatin1String( "Directory with archive in yyyy/MM/dd layout." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'o' ), QLatin1String( "output" ),
+				true, false, QLatin1String( "Output file, standard output by default." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'f' ), QLatin1String( "format" ),
+				true, false, QLatin1String( "Output format, csv or json." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'j' ), QLatin1String( "jobs" ),
+				true, false, QLatin1String( "Count of days processed in parallel." ) )
+			.addArgWithFlagAndName( QLatin1Char( 't' ), QLatin1String( "threshold" ),
+				true, false, QLatin1String( "Threshold of the detector." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'e' ), QLatin1String( "off-threshold" ),
+				true, false, QLatin1String( "Threshold of end of motion." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'n' ), QLatin1String( "confirmations" ),
+				true, false, QLatin1String( "Confirmations of start and end of motion." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'm' ), QLatin1String( "window" ),
+				true, false, QLatin1String( "Window of confirmations in frames." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'u' ), QLatin1String( "duration" ),
+				true, false, QLatin1String( "Minimum duration of event in milliseconds." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'b' ), QLatin1String( "blob" ),
+				true, false, QLatin1String( "Threshold of difference of pixel for blobs, "
+					"0 means mean difference." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'a' ), QLatin1String( "blob-area" ),
+				true, false, QLatin1String( "Minimum area of blob, fraction of the frame." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'c' ), QLatin1String( "blob-count" ),
+				true, false, QLatin1String( "Minimum count of blobs." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'l' ), QLatin1String( "lighting" ),
+				true, false, QLatin1String( "Compensate lighting with the given threshold." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'w' ), QLatin1String( "width" ),
+				true, false, QLatin1String( "Width of frames for detection." ) )
+			.addHelp( true, argv[ 0 ],
+				QLatin1String( "Replays archive of stills through the motion detector." ) );
+
+		cmd.parse( argc, argv );
+
+		archive = cmd.value( QLatin1String( "-d" ) );
+
+		if( cmd.isDefined( QLatin1String( "-o" ) ) )
+			output = cmd.value( QLatin1String( "-o" ) );
+
+		if( cmd.isDefined( QLatin1String( "-f" ) ) )
+			format = cmd.value( QLatin1String( "-f" ) ).toLower();
+
+		if( cmd.isDefined( QLatin1String( "-j" ) ) )
+			jobs = qMax( 1, cmd.value( QLatin1String( "-j" ) ).toInt() );
+
+		if( cmd.isDefined( QLatin1String( "-t" ) ) )
+			opts.m_threshold = cmd.value( QLatin1String( "-t" ) ).toDouble();
+
+		if( cmd.isDefined( QLatin1String( "-e" ) ) )
+			opts.m_offThreshold = cmd.value( QLatin1String( "-e" ) ).toDouble();
+
+		if( cmd.isDefined( QLatin1String( "-n" ) ) )
+			opts.m_confirmations = cmd.value( QLatin1String( "-n" ) ).toInt();
+
+		if( cmd.isDefined( QLatin1String( "-m" ) ) )
+			opts.m_window = cmd.value( QLatin1String( "-m" ) ).toInt();
+
+		if( cmd.isDefined( QLatin1String( "-u" ) ) )
+			opts.m_minDuration = cmd.value( QLatin1String( "-u" ) ).toInt();
+
+		if( cmd.isDefined( QLatin1String( "-b" ) ) )
+			opts.m_blobThreshold = cmd.value( QLatin1String( "-b" ) ).toDouble();
+
+		if( cmd.isDefined( QLatin1String( "-a" ) ) )
+			opts.m_minBlobArea = cmd.value( QLatin1String( "-a" ) ).toDouble();
+
+		if( cmd.isDefined( QLatin1String( "-c" ) ) )
+			opts.m_minBlobCount = cmd.value( QLatin1String( "-c" ) ).toInt();
+
+		if( cmd.isDefined( QLatin1String( "-l" ) ) )
+		{
+			opts.m_lightCompensation = true;
+			opts.m_lightingThreshold = cmd.value( QLatin1String( "-l" ) ).toDouble();
+		}
+
+		if( cmd.isDefined( QLatin1String( "-w" ) ) )
+			opts.m_detectionWidth = cmd.value( QLatin1String( "-w" ) ).toInt();
+	}
+	catch( const Args::HelpHasBeenPrintedException & )
+	{
+		return 0;
+	}
+	catch( const Args::BaseException & x )
+	{
+		QTextStream( stderr ) << x.desc() << "\n";
+
+		return 1;
+	}
+
+	QTextStream err( stderr );
+
+	if( format != QStringLiteral( "csv" ) && format != QStringLiteral( "json" ) )
+	{
+		err << "Unknown format \"" << format << "\".\n";
+
+		return 1;
+	}
+
+	const auto days = scanArchive( archive );
+
+	if( days.isEmpty() )
+	{
+		err << "No days in \"" << archive << "\".\n";
+
+		return 1;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	// Every day is replayed by its own detector, so days are independent
+	// and only one decoded frame per job is in memory.
+	QVector< QVector< Event > > results( days.size() );
+	QVector< qint64 > frames( days.size(), 0 );
+	QVector< Event > * res = results.data();
+	qint64 * counts = frames.data();
+
+	QThreadPool pool;
+	pool.setMaxThreadCount( jobs );
+
+	for( int i = 0; i < days.size(); ++i )
+	{
+		const Day day = days.at( i );
+
+		pool.start( [res, counts, i, day, opts] ()
+			{
+				res[ i ] = replayDay( day, opts, counts[ i ] );
+			} );
+	}
+
+	pool.waitForDone();
+
+	QVector< Event > events;
+	qint64 total = 0;
+
+	for( int i = 0; i < days.size(); ++i )
+	{
+		events.append( results.at( i ) );
+		total += frames.at( i );
+	}
+
+	QFile file;
+
+	if( output.isEmpty() )
+		file.open( stdout, QIODevice::WriteOnly | QIODevice::Text );
+	else
+	{
+		file.setFileName( output );
+
+		if( !file.open( QIODevice::WriteOnly | QIODevice::Text ) )
+		{
+			err << "Unable to write \"" << output << "\".\n";
+
+			return 1;
+		}
+	}
+
+	QTextStream out( &file );
+
+	if( format == QStringLiteral( "json" ) )
+		writeJson( out, events );
+	else
+		writeCsv( out, events );
+
+	err << "Days " << days.size() << ", frames " << total
+		<< ", events " << events.size() << ", "
+		<< QString::number( timer.elapsed() / 1000.0, 'f', 1 ) << " s\n";
+
+	return 0;
+}
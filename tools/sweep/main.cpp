@@ -0,0 +1,341 @@
+
+/*
+	SPDX-FileCopyrightText: 2016-2024 Igor Mironchik <igor.mironchik@gmail.com>
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+// SecurityCam include.
+#include <detector.hpp>
+#include <scale.hpp>
+#include <dataset.hpp>
+
+// Qt include.
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+// Args include.
+#include <args-parser/all.hpp>
+
+// C++ include.
+#include <memory>
+#include <algorithm>
+
+
+//
+// Config
+//
+
+//! Configuration of the detector.
+struct Config {
+	//! Threshold.
+	qreal m_threshold;
+	//! Width of frames for detection, 0 means as is.
+	int m_width;
+	//! Confirmations of motion.
+	int m_confirmations;
+	//! Window of confirmations.
+	int m_window;
+	//! Threshold of difference of pixel for blobs, 0 means mean difference.
+	qreal m_blobThreshold;
+}; // struct Config
+
+
+//! \return List of numbers separated with comma.
+static QVector< qreal >
+readList( const QString & value )
+{
+	QVector< qreal > res;
+
+	const auto parts = value.split( QLatin1Char( ',' ), Qt::SkipEmptyParts );
+
+	for( const auto & p : parts )
+		res.append( p.trimmed().toDouble() );
+
+	return res;
+}
+
+//! \return All combinations of the given values.
+static QVector< Config >
+combinations( const QVector< qreal > & thresholds, const QVector< qreal > & widths,
+	const QVector< qreal > & confirmations, const QVector< qreal > & windows,
+	const QVector< qreal > & blobThresholds )
+{
+	QVector< Config > res;
+
+	for( const auto w : widths )
+		for( const auto t : thresholds )
+			for( const auto n : confirmations )
+				for( const auto m : windows )
+				{
+					if( m < n )
+						continue;
+
+					for( const auto b : blobThresholds )
+					{
+						Config c;
+						c.m_threshold = t;
+						c.m_width = (int) w;
+						c.m_confirmations = (int) n;
+						c.m_window = (int) m;
+						c.m_blobThreshold = b;
+
+						res.append( c );
+					}
+				}
+
+	return res;
+}
+
+//! Run all configurations on the sequence. Every frame is decoded once and
+//! scaled once per width, then is passed to detectors of all configurations.
+static QVector< Result >
+runSequence( const Sequence & seq, const QVector< Config > & configs )
+{
+	QVector< Result > res( configs.size() );
+
+	std::vector< std::unique_ptr< SecurityCam::Detector > > detectors;
+
+	QVector< int > widths;
+
+	for( const auto & c : configs )
+	{
+		detectors.emplace_back( new SecurityCam::Detector( c.m_threshold ) );
+		detectors.back()->setHysteresis( c.m_confirmations, c.m_window, 0 );
+		detectors.back()->setBlobRules( c.m_blobThreshold, 0.001, 1 );
+
+		if( !widths.contains( c.m_width ) )
+			widths.append( c.m_width );
+	}
+
+	QElapsedTimer timer;
+
+	for( const auto & s : seq.m_samples )
+	{
+		const QImage image = QImage( s.m_fileName )
+			.convertToFormat( QImage::Format_RGB32 );
+
+		if( image.isNull() )
+			continue;
+
+		for( const auto w : qAsConst( widths ) )
+		{
+			timer.start();
+
+			const QImage scaled = ( w > 0 && image.width() > w ?
+				SecurityCam::scaleToFit( image, QSize( w, image.height() ) ) : image );
+
+			// Every configuration of this width pays for scaling.
+			const qint64 scaleTime = timer.nsecsElapsed();
+
+			for( int i = 0; i < configs.size(); ++i )
+			{
+				if( configs.at( i ).m_width != w )
+					continue;
+
+				Result & r = res[ i ];
+
+				timer.start();
+
+				const bool detected = detectors[ i ]->process( scaled );
+
+				r.m_nsecs += timer.nsecsElapsed() + scaleTime;
+				++r.m_frames;
+
+				// First frame has nothing to be compared with.
+				if( !detectors[ i ]->hasDifference() )
+					continue;
+
+				r.count( detected, s.m_motion );
+			}
+		}
+	}
+
+	return res;
+}
+
+
+int main( int argc, char ** argv )
+{
+	QCoreApplication app( argc, argv );
+
+	QString dataSet;
+	QString output;
+	QString thresholds = QStringLiteral( "0.01,0.02,0.03,0.05" );
+	QString widths = QStringLiteral( "0" );
+	QString confirmations = QStringLiteral( "1" );
+	QString windows = QStringLiteral( "1" );
+	QString blobThresholds = QStringLiteral( "0" );
+	int jobs = QThread::idealThreadCount();
+
+	try {
+		Args::CmdLine cmd;
+
+		cmd.addArgWithFlagAndName( QLatin1Char( 'd' ), QLatin1String( "data" ),
+				true, true, QLatin1String( "Directory with labelled sequences." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'o' ), QLatin1String( "output" ),
+				true, false, QLatin1String( "Output CSV file, standard output by default." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'j' ), QLatin1String( "jobs" ),
+				true, false, QLatin1String( "Count of parallel jobs." ) )
+			.addArgWithFlagAndName( QLatin1Char( 't' ), QLatin1String( "threshold" ),
+				true, false, QLatin1String( "Thresholds, separated with comma." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'w' ), QLatin1String( "width" ),
+				true, false, QLatin1String( "Widths of frames for detection, 0 means as is." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'n' ), QLatin1String( "confirmations" ),
+				true, false, QLatin1String( "Confirmations of start and end of motion." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'm' ), QLatin1String( "window" ),
+				true, false, QLatin1String( "Windows of confirmations in frames." ) )
+			.addArgWithFlagAndName( QLatin1Char( 'b' ), QLatin1String( "blob" ),
+				true, false, QLatin1String( "Thresholds of difference of pixel for blobs, "
+					"0 means mean difference." ) )
+			.addHelp( true, argv[ 0 ],
+				QLatin1String( "Evaluates combinations of settings of the motion detector "
+					"on labelled sequences." ) );
+
+		cmd.parse( argc, argv );
+
+		dataSet = cmd.value( QLatin1String( "-d" ) );
+
+		if( cmd.isDefined( QLatin1String( "-o" ) ) )
+			output = cmd.value( QLatin1String( "-o" ) );
+
+		if( cmd.isDefined( QLatin1String( "-j" ) ) )
+			jobs = qMax( 1, cmd.value( QLatin1String( "-j" ) ).toInt() );
+
+		if( cmd.isDefined( QLatin1String( "-t" ) ) )
+			thresholds = cmd.value( QLatin1String( "-t" ) );
+
+		if( cmd.isDefined( QLatin1String( "-w" ) ) )
+			widths = cmd.value( QLatin1String( "-w" ) );
+
+		if( cmd.isDefined( QLatin1String( "-n" ) ) )
+			confirmations = cmd.value( QLatin1String( "-n" ) );
+
+		if( cmd.isDefined( QLatin1String( "-m" ) ) )
+			windows = cmd.value( QLatin1String( "-m" ) );
+
+		if( cmd.isDefined( QLatin1String( "-b" ) ) )
+			blobThresholds = cmd.value( QLatin1String( "-b" ) );
+	}
+	catch( const Args::HelpHasBeenPrintedException & )
+	{
+		return 0;
+	}
+	catch( const Args::BaseException & x )
+	{
+		QTextStream( stderr ) << x.desc() << "\n";
+
+		return 1;
+	}
+
+	QTextStream err( stderr );
+
+	const auto sequences = readDataSet( dataSet );
+
+	if( sequences.isEmpty() )
+	{
+		err << "No labelled sequences in \"" << dataSet << "\".\n";
+
+		return 1;
+	}
+
+	const auto configs = combinations( readList( thresholds ), readList( widths ),
+		readList( confirmations ), readList( windows ), readList( blobThresholds ) );
+
+	if( configs.isEmpty() )
+	{
+		err << "No configurations to evaluate.\n";
+
+		return 1;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	// Configurations are split into chunks, so there is work for all jobs
+	// with few sequences too. Configurations are ordered by width, so
+	// configurations of a chunk mostly share scaling of frames.
+	const int configsCount = configs.size();
+	const int sequencesCount = sequences.size();
+	const int chunks = qMin( configsCount,
+		( jobs + sequencesCount - 1 ) / sequencesCount );
+	const int chunkSize = ( configsCount + chunks - 1 ) / chunks;
+
+	QVector< QVector< Result > > results( sequences.size(),
+		QVector< Result > ( configs.size() ) );
+
+	QThreadPool pool;
+	pool.setMaxThreadCount( jobs );
+
+	for( int i = 0; i < sequences.size(); ++i )
+	{
+		Result * res = results[ i ].data();
+		const Sequence seq = sequences.at( i );
+
+		for( int from = 0; from < configs.size(); from += chunkSize )
+		{
+			const QVector< Config > chunk = configs.mid( from, chunkSize );
+
+			pool.start( [res, from, seq, chunk] ()
+				{
+					const auto r = runSequence( seq, chunk );
+
+					std::copy( r.cbegin(), r.cend(), res + from );
+				} );
+		}
+	}
+
+	pool.waitForDone();
+
+	QVector< Result > total( configs.size() );
+
+	for( const auto & r : qAsConst( results ) )
+	{
+		for( int i = 0; i < configs.size(); ++i )
+			total[ i ].add( r.at( i ) );
+	}
+
+	QFile file;
+
+	if( output.isEmpty() )
+		file.open( stdout, QIODevice::WriteOnly | QIODevice::Text );
+	else
+	{
+		file.setFileName( output );
+
+		if( !file.open( QIODevice::WriteOnly | QIODevice::Text ) )
+		{
+			err << "Unable to write \"" << output << "\".\n";
+
+			return 1;
+		}
+	}
+
+	QTextStream out( &file );
+
+	out << "threshold,width,confirmations,window,blob,precision,recall,cost\n";
+
+	for( int i = 0; i < configs.size(); ++i )
+	{
+		const auto & c = configs.at( i );
+		const auto & r = total.at( i );
+
+		out << c.m_threshold << "," << c.m_width << ","
+			<< c.m_confirmations << "," << c.m_window << ","
+			<< c.m_blobThreshold << ","
+			<< QString::number( r.precision(), 'f', 3 ) << ","
+			<< QString::number( r.recall(), 'f', 3 ) << ","
+			<< QString::number( r.cost(), 'f', 1 ) << "\n";
+	}
+
+	err << "Sequences " << sequences.size() << ", configurations "
+		<< configs.size() << ", "
+		<< QString::number( timer.elapsed() / 1000.0, 'f', 1 ) << " s\n";
+
+	return 0;
+}